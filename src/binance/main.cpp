@@ -16,6 +16,8 @@
 #include "../main/istockapi.h"
 #include <cmath>
 #include <ctime>
+#include <memory>
+#include <thread>
 
 #include "../brokers/api.h"
 #include <imtjson/stringValue.h>
@@ -46,6 +48,7 @@ public:
 			json::Value clientId,
 			json::Value replaceId,
 			double replaceSize)override;
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders) override;
 	virtual bool reset()override;
 	virtual MarketInfo getMarketInfo(const std::string_view & pair)override;
 	virtual double getFees(const std::string_view &pair)override;
@@ -79,6 +82,12 @@ public:
 
 	std::intptr_t time_diff;
 	std::uintptr_t idsrc;
+	///extra connections of placeOrders(), the first order is placed through px
+	std::vector<std::unique_ptr<Proxy> > orderProxies;
+
+	static Value placeOrderWith(Proxy &p, const std::string_view & pair,
+			double size, double price, Value orderId,
+			Value replaceId, double replaceSize);
 
 
 };
@@ -276,8 +285,48 @@ json::Value Interface::placeOrder(const std::string_view & pair,
 		json::Value replaceId,
 		double replaceSize) {
 
+	return placeOrderWith(px, pair, size, price, generateOrderId(clientId), replaceId, replaceSize);
+}
+
+std::vector<Interface::OrderResult> Interface::placeOrders(const std::vector<OrderRequest> &orders) {
+	std::vector<OrderResult> res(orders.size());
+	if (orders.empty()) return res;
+	//ids are generated here, generateOrderId is not thread safe
+	std::vector<Value> ids;
+	ids.reserve(orders.size());
+	for (auto &&o: orders) ids.push_back(generateOrderId(o.clientId));
+	while (orderProxies.size()+1 < orders.size()) {
+		orderProxies.push_back(std::make_unique<Proxy>(px.config));
+	}
+
+	auto place = [&](Proxy &p, std::size_t i) {
+		const OrderRequest &o = orders[i];
+		try {
+			res[i].id = placeOrderWith(p, o.pair, o.size, o.price, ids[i], o.replaceId, o.replaceSize);
+		} catch (std::exception &e) {
+			res[i].error = e.what();
+		}
+	};
+
+	//each order is placed through its own connection, so the orders are placed concurrently
+	std::vector<std::thread> thrs;
+	thrs.reserve(orders.size()-1);
+	for (std::size_t i = 1; i < orders.size(); i++) {
+		Proxy &p = *orderProxies[i-1];
+		p.debug = px.debug;
+		thrs.emplace_back(place, std::ref(p), i);
+	}
+	place(px, 0);
+	for (auto &&t: thrs) t.join();
+	return res;
+}
+
+Value Interface::placeOrderWith(Proxy &p, const std::string_view & pair,
+		double size, double price, Value orderId,
+		Value replaceId, double replaceSize) {
+
 	if (replaceId.defined()) {
-		Value r = px.private_request(Proxy::DELETE,"/api/v3/order",Object
+		Value r = p.private_request(Proxy::DELETE,"/api/v3/order",Object
 				("symbol", pair)
 				("orderId", replaceId));
 		double remain = r["origQty"].getNumber() - r["executedQty"].getNumber();
@@ -287,8 +336,7 @@ json::Value Interface::placeOrder(const std::string_view & pair,
 
 	if (size == 0) return nullptr;
 
-	Value orderId = generateOrderId(clientId);
-	px.private_request(Proxy::POST,"/api/v3/order",Object
+	p.private_request(Proxy::POST,"/api/v3/order",Object
 			("symbol", pair)
 			("side", size<0?"SELL":"BUY")
 			("type","LIMIT_MAKER")
@@ -73,6 +73,29 @@ static Value placeOrder(IStockApi &handler, const Value &req) {
 			req["replaceOrderSize"].getNumber());
 }
 
+static Value placeOrders(IStockApi &handler, const Value &req) {
+	std::vector<IStockApi::OrderRequest> orders;
+	orders.reserve(req.size());
+	for (Value o: req) {
+		orders.push_back(IStockApi::OrderRequest{
+			std::string(o["pair"].getString()),
+			o["size"].getNumber(),
+			o["price"].getNumber(),
+			o["clientOrderId"],
+			o["replaceOrderId"],
+			o["replaceOrderSize"].getNumber()
+		});
+	}
+	auto res = handler.placeOrders(orders);
+	Array response;
+	response.reserve(res.size());
+	for (auto &&r: res) {
+		if (r.error.empty()) response.push_back({true, r.id});
+		else response.push_back({false, r.error.c_str()});
+	}
+	return response;
+}
+
 static Value enableDebug(IStockApi &handler, const Value &req) {
 	AbstractBrokerAPI *h = dynamic_cast<AbstractBrokerAPI *>(&handler);
 	if (h) {
@@ -127,6 +150,7 @@ static MethodMap methodMap ({
 			{"getOpenOrders",&getOpenOrders},
 			{"getTicker",&getTicker},
 			{"placeOrder",&placeOrder},
+			{"placeOrders",&placeOrders},
 			{"reset",&reset},
 			{"getAllPairs",&getAllPairs},
 			{"getFees",&getFees},
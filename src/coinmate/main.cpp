@@ -12,6 +12,7 @@
 #include "config.h"
 #include "proxy.h"
 #include "../main/istockapi.h"
+#include "../main/trade_id_index.h"
 #include "../shared/linear_map.h"
 #include <brokers/api.h>
 
@@ -45,6 +46,8 @@ public:
 	Value balanceCache;
 	Value orderCache;
 	Array trades;
+	///index of transaction ids in the trades
+	TradeIdIndex tradeIndex;
 	bool fetchTrades = true;
 	Value firstId;
 	Value all_pairs;
@@ -94,6 +97,7 @@ Interface::TradeHistory Interface::getTrades(json::Value lastId, std::uintptr_t
 
 		if (!lastId.defined() && fromTime < lastFrom) {
 			trades.clear();
+			tradeIndex.clear();
 			fetchTrades = true;
 		}
 
@@ -114,30 +118,31 @@ Interface::TradeHistory Interface::getTrades(json::Value lastId, std::uintptr_t
 			fetchTrades = false;
 		}
 
-		auto start = lastId.defined()?
-				(lastId == firstId?trades.begin():
-						std::find_if(trades.begin(), trades.end(), [&](const Value &v) {
-			return v["transactionId"] == lastId;
-		})):trades.begin();
+		std::size_t start = 0;
+		if (lastId.defined() && lastId != firstId) {
+			auto pos = tradeIndex.find(trades, [](const Value &v) {return v["transactionId"];}, lastId);
+			start = pos.has_value()?*pos:trades.size();
+		}
 
 		Value result;
-		if (start == trades.end() && lastId.defined()) {
+		if (start == trades.size() && lastId.defined()) {
 			trades.clear();
+			tradeIndex.clear();
 			Value res = readTradesPerPartes(lastId,fromTime);
 			trades.addSet(res);
-			start = trades.begin();
+			start = 0;
 			firstId = lastId;
 		}
 
-		if (start == trades.end()) return {};
+		if (start == trades.size()) return {};
 
 		lastFrom = fromTime?fromTime:trades[0]["createdTimestamp"].getUInt();
 
-		if ((*start)["transactionId"] == lastId)
+		if (trades[start]["transactionId"] == lastId)
 			++start;
 		Array part;
-		while (start != trades.end()) {
-			Value v = *start;
+		while (start != trades.size()) {
+			Value v = trades[start];
 			if (v["currencyPair"] == pair)
 				part.push_back(v);
 			++start;
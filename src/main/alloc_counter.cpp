@@ -0,0 +1,89 @@
+/*
+ * alloc_counter.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "alloc_counter.h"
+
+#ifdef MMBOT_ALLOC_COUNTER
+
+#include <cstdlib>
+#include <new>
+
+static thread_local std::size_t alloc_count = 0;
+
+std::size_t AllocCounter::get() {
+	return alloc_count;
+}
+
+static void *counted_alloc(std::size_t sz) noexcept {
+	++alloc_count;
+	if (sz == 0) sz = 1;
+	return std::malloc(sz);
+}
+
+static void *counted_alloc(std::size_t sz, std::align_val_t al) noexcept {
+	++alloc_count;
+	std::size_t a = static_cast<std::size_t>(al);
+	if (a < sizeof(void *)) a = sizeof(void *);
+	void *p = nullptr;
+	if (posix_memalign(&p, a, sz?sz:1)) return nullptr;
+	return p;
+}
+
+void *operator new(std::size_t sz) {
+	void *p = counted_alloc(sz);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](std::size_t sz) {
+	void *p = counted_alloc(sz);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(std::size_t sz, const std::nothrow_t &) noexcept {
+	return counted_alloc(sz);
+}
+
+void *operator new[](std::size_t sz, const std::nothrow_t &) noexcept {
+	return counted_alloc(sz);
+}
+
+void *operator new(std::size_t sz, std::align_val_t al) {
+	void *p = counted_alloc(sz, al);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](std::size_t sz, std::align_val_t al) {
+	void *p = counted_alloc(sz, al);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(std::size_t sz, std::align_val_t al, const std::nothrow_t &) noexcept {
+	return counted_alloc(sz, al);
+}
+
+void *operator new[](std::size_t sz, std::align_val_t al, const std::nothrow_t &) noexcept {
+	return counted_alloc(sz, al);
+}
+
+//all forms allocate by malloc or posix_memalign, so all of them release by free
+void operator delete(void *ptr) noexcept {std::free(ptr);}
+void operator delete[](void *ptr) noexcept {std::free(ptr);}
+void operator delete(void *ptr, std::size_t) noexcept {std::free(ptr);}
+void operator delete[](void *ptr, std::size_t) noexcept {std::free(ptr);}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {std::free(ptr);}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {std::free(ptr);}
+void operator delete(void *ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void *ptr, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {std::free(ptr);}
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {std::free(ptr);}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {std::free(ptr);}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * alloc_counter.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_ALLOC_COUNTER_H_
+#define SRC_MAIN_ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+///Counts heap allocations of the current thread (debugging)
+/**
+ * The counter is active only when the program is built with MMBOT_ALLOC_COUNTER
+ * defined (cmake -DALLOC_COUNTER=ON). In this case all forms of the global operator new
+ * and operator delete (array, nothrow, aligned) are replaced.
+ * Otherwise the counter always returns zero and costs nothing.
+ */
+class AllocCounter {
+public:
+
+#ifdef MMBOT_ALLOC_COUNTER
+	static constexpr bool enabled = true;
+	///Returns count of allocations made by the current thread
+	static std::size_t get();
+#else
+	static constexpr bool enabled = false;
+	static std::size_t get() {return 0;}
+#endif
+
+	///Measures allocations made during lifetime of the object
+	class Scope {
+	public:
+		Scope():start(get()) {}
+		std::size_t count() const {return get() - start;}
+	protected:
+		std::size_t start;
+	};
+};
+
+
+#endif /* SRC_MAIN_ALLOC_COUNTER_H_ */
@@ -7,24 +7,37 @@
 
 
 #include "backtest.h"
-#include "stats2report.h"
 
-BacktestControl::BacktestControl(IStockSelector &stockSel,
-		Report &rpt, Config config,
-		ondra_shared::StringView<IStatSvc::ChartItem> chart,
+#include <algorithm>
+
+#include <imtjson/object.h>
+#include "spread_calc.h"
+
+BacktestControl::BacktestControl(const IStockApi::MarketInfo &minfo,
+		PStatSvc &&statsvc, Config config,
+		const ChartSoA::View &chart,
 		double spread, double balance) {
+	broker.emplace(chart, minfo, 0);
+	init(minfo, std::move(statsvc), config, spread, balance);
+}
 
+BacktestControl::BacktestControl(const IStockApi::MarketInfo &minfo,
+		PStatSvc &&statsvc, Config config,
+		ondra_shared::StringView<IStatSvc::ChartItem> chart,
+		double spread, double balance) {
+	broker.emplace(chart, minfo, 0);
+	init(minfo, std::move(statsvc), config, spread, balance);
+}
 
-	IStockApi *orig_broker = stockSel.getStock(config.mtrader_cfg.broker);
-	if (orig_broker == nullptr)
-		throw std::runtime_error(std::string("Unknown stock market name: ")+std::string(config.mtrader_cfg.broker));
+void BacktestControl::init(const IStockApi::MarketInfo &minfo, PStatSvc &&statsvc, Config &config, double spread, double balance) {
 
-	auto minfo = orig_broker->getMarketInfo(config.mtrader_cfg.pairsymb);
 	if (config.calc_spread_minutes == 0 && config.mtrader_cfg.force_spread == 0) {
 		config.mtrader_cfg.force_spread = spread;
 	}
-
-	PStatSvc statsvc ( new Stats2Report([=](CalcSpreadFn &&fn) {fn();}, "backtest", rpt, config.calc_spread_minutes));
+	//the tiers would be rebuilt every step, while the spread is calculated only once per
+	//interval. The backtest starts with empty tiers anyway, so the minute chart is used
+	config.mtrader_cfg.spread_calc_tier = 1;
+	config.mtrader_cfg.chart_history_days = 0;
 
 	class FakeStockSelector: public IStockSelector {
 	public:
@@ -42,8 +55,10 @@ BacktestControl::BacktestControl(IStockSelector &stockSel,
 	};
 
 
+	checkpoint_file = config.checkpoint_file;
+	checkpoint_interval = config.checkpoint_interval;
+
 	config.mtrader_cfg.title="BT:"+config.mtrader_cfg.title;
-	broker.emplace(chart, minfo, 0);
 	FakeStockSelector fakeStockSell(&(*broker));
 	trader.emplace(fakeStockSell, nullptr, std::move(statsvc), config.mtrader_cfg);
 	trader->setInternalBalance(balance);
@@ -54,9 +69,140 @@ BacktestControl::BacktestControl(IStockSelector &stockSel,
 bool BacktestControl::step() {
 	if (!broker->reset()) return false;
 	trader->perform();
+	double eq = broker->getEquity();
+	peak_equity = std::max(peak_equity, eq);
+	max_drawdown = std::max(max_drawdown, peak_equity - eq);
+	++steps;
+	if (checkpoint_interval && steps % checkpoint_interval == 0) saveCheckpoint();
 	return true;
 }
 
+BacktestControl::Sample BacktestControl::getSample() const {
+	return Sample {
+		broker->getTime(),
+		broker->getEquity(),
+		broker->getExposure()
+	};
+}
+
+json::Value BacktestControl::checkpoint() const {
+	return json::Object
+			("version", 1)
+			("steps", steps)
+			("peak_equity", peak_equity)
+			("max_drawdown", max_drawdown)
+			("broker", broker->exportState())
+			("trader", trader->exportState());
+}
+
+void BacktestControl::resume(json::Value cp) {
+	if (cp["version"].getUInt() != 1) throw std::runtime_error("Unsupported checkpoint");
+	broker->importState(cp["broker"]);
+	trader->importState(cp["trader"]);
+	steps = cp["steps"].getUInt();
+	peak_equity = cp["peak_equity"].getNumber();
+	max_drawdown = cp["max_drawdown"].getNumber();
+}
+
+void BacktestControl::saveCheckpoint() {
+	if (checkpoint_file.empty()) return;
+	Storage(checkpoint_file, 2, Storage::binjson).store(checkpoint());
+}
+
+json::Value BacktestControl::loadCheckpoint(const std::string &fname) {
+	return Storage(fname, 2, Storage::binjson).load();
+}
+
+BacktestControl::Result BacktestControl::getResult() const {
+	return Result {
+		broker->getEquity(),
+		broker->getTradeCount(),
+		max_drawdown
+	};
+}
+
+double BacktestStatSvc::calcSpread(ondra_shared::StringView<ChartItem> chart,
+			const MTrader_Config &config,
+			const IStockApi::MarketInfo &minfo,
+			double balance,
+			double prev_value) const {
+	if (spread == 0) spread = prev_value;
+	if (cnt <= 0) {
+		cnt += interval;
+		spread = glob_calcSpread(chart, config, minfo, balance, spread);
+	} else {
+		--cnt;
+	}
+	return spread;
+}
+
+void BacktestReportSvc::reportOrders(const std::optional<IStockApi::Order> &buy,
+		const std::optional<IStockApi::Order> &sell) {
+	orders = Orders{buy, sell};
+}
+
+void BacktestReportSvc::reportTrades(ondra_shared::StringView<IStockApi::TradeWithBalance> trades) {
+	this->trades = trades;
+}
+
+void BacktestReportSvc::reportPrice(double price) {
+	this->price = price;
+}
+
+void BacktestReportSvc::setInfo(const Info &info) {
+	this->info = InfoData{
+		std::string(info.title),
+		std::string(info.assetSymb),
+		std::string(info.currencySymb),
+		std::string(info.priceSymb),
+		info.inverted,
+		info.margin,
+		info.emulated
+	};
+}
+
+void BacktestReportSvc::reportMisc(const MiscData &misc) {
+	this->misc = misc;
+}
+
+void BacktestReportSvc::reportError(const ErrorObj &error) {
+	this->error = ErrorData{
+		std::string(error.genError),
+		std::string(error.buyError),
+		std::string(error.sellError)
+	};
+}
+
+void BacktestReportSvc::flush(IStatSvc &target) {
+	if (info) {
+		target.setInfo(Info{info->title, info->assetSymb, info->currencySymb, info->priceSymb,
+			info->inverted, info->margin, info->emulated});
+		info.reset();
+	}
+	if (orders) {
+		target.reportOrders(orders->buy, orders->sell);
+		orders.reset();
+	}
+	if (trades) {
+		target.reportTrades(*trades);
+		trades.reset();
+	}
+	if (price) {
+		target.reportPrice(*price);
+		price.reset();
+	}
+	if (misc) {
+		target.reportMisc(*misc);
+		misc.reset();
+	}
+	if (error) {
+		ErrorObj e(error->buyError, error->sellError);
+		e.genError = error->genError;
+		target.reportError(e);
+		error.reset();
+	}
+}
+
 BacktestControl::Config BacktestControl::loadConfig(const std::string &fname,
 		const std::string &section,
 		const std::vector<ondra_shared::IniItem> &custom_options) {
@@ -69,5 +215,11 @@ BacktestControl::Config BacktestControl::loadConfig(const std::string &fname,
 	Config c;
 	c.mtrader_cfg = MTrader::load(cfg[section],true);
 	c.calc_spread_minutes = cfg[section]["spread_calc_interval"].getUInt(0);
+	c.chart_tier = cfg[section]["backtest_tier"].getUInt(1);
+	auto chart_file = cfg[section]["chart_file"];
+	if (chart_file.defined()) c.chart_file = chart_file.getPath();
+	auto checkpoint_file = cfg[section]["checkpoint_file"];
+	if (checkpoint_file.defined()) c.checkpoint_file = checkpoint_file.getPath();
+	c.checkpoint_interval = cfg[section]["checkpoint_interval"].getUInt(10000);
 	return c;
 }
@@ -16,16 +16,125 @@
 #include "mtrader.h"
 
 
+///Statistic service for backtests which doesn't generate a report
+/**
+ * Everything reported is discarded. The spread is calculated synchronously
+ * in the calling thread, so multiple backtests can run in parallel
+ */
+class BacktestStatSvc: public IStatSvc {
+public:
+	///Constructs the service
+	/**
+	 * @param interval count of cycles between recalculations of the spread
+	 * @param hash value returned by getHash(). The trader uses it to mark its orders
+	 */
+	BacktestStatSvc(int interval, std::size_t hash = 0):interval(interval),hash(hash) {}
+
+	virtual void reportOrders(const std::optional<IStockApi::Order> &,
+							  const std::optional<IStockApi::Order> &) override {}
+	virtual void reportTrades(ondra_shared::StringView<IStockApi::TradeWithBalance> ) override {}
+	virtual void reportPrice(double ) override {}
+	virtual void setInfo(const Info &) override {}
+	virtual void reportMisc(const MiscData &) override {}
+	virtual void reportError(const ErrorObj &) override {}
+	virtual double calcSpread(ondra_shared::StringView<ChartItem> chart,
+			const MTrader_Config &config,
+			const IStockApi::MarketInfo &minfo,
+			double balance,
+			double prev_value) const override;
+	virtual std::size_t getHash() const override {return hash;}
+
+protected:
+	int interval;
+	std::size_t hash;
+	mutable int cnt = 0;
+	mutable double spread = 0;
+};
+
+///Statistic service for backtests which keeps the last reported values
+/**
+ * The backtest can run in any thread. The values are passed to the report by flush(),
+ * which must be called in the thread which owns the report, while the backtest is not
+ * running (the trades are not copied)
+ */
+class BacktestReportSvc: public BacktestStatSvc {
+public:
+	using BacktestStatSvc::BacktestStatSvc;
+
+	virtual void reportOrders(const std::optional<IStockApi::Order> &buy,
+							  const std::optional<IStockApi::Order> &sell) override;
+	virtual void reportTrades(ondra_shared::StringView<IStockApi::TradeWithBalance> trades) override;
+	virtual void reportPrice(double price) override;
+	virtual void setInfo(const Info &info) override;
+	virtual void reportMisc(const MiscData &misc) override;
+	virtual void reportError(const ErrorObj &error) override;
+
+	///Sends values reported since the last flush to the target
+	void flush(IStatSvc &target);
+
+protected:
+	struct Orders {
+		std::optional<IStockApi::Order> buy, sell;
+	};
+	struct InfoData {
+		std::string title, assetSymb, currencySymb, priceSymb;
+		bool inverted, margin, emulated;
+	};
+	struct ErrorData {
+		std::string genError, buyError, sellError;
+	};
+	std::optional<Orders> orders;
+	std::optional<ondra_shared::StringView<IStockApi::TradeWithBalance> > trades;
+	std::optional<double> price;
+	std::optional<InfoData> info;
+	std::optional<MiscData> misc;
+	std::optional<ErrorData> error;
+};
+
 class BacktestControl {
 public:
 
 	struct Config {
 		MTrader::Config mtrader_cfg;
 		std::size_t calc_spread_minutes;
+		///resolution of the chart in minutes (1, 15, 60)
+		unsigned int chart_tier;
+		///file with the chart (binary or csv), empty to use the trader's chart
+		std::string chart_file;
+		///file where checkpoints are stored, empty to disable checkpoints
+		std::string checkpoint_file;
+		///count of steps between checkpoints
+		std::size_t checkpoint_interval = 10000;
 	};
 
-	BacktestControl(IStockSelector &stockSel,
-					Report &rpt,
+	///Result of the backtest
+	struct Result {
+		///profit in currency (change of the equity)
+		double profit;
+		///count of trades (pairs of buy and sell)
+		unsigned int trades;
+		///maximum drawdown of the equity
+		double drawdown;
+	};
+
+	///Creates backtest over the shared chart
+	/**
+	 * @param minfo market info
+	 * @param statsvc statistic service (for example BacktestStatSvc)
+	 * @param config configuration
+	 * @param chart chart - must stay valid during lifetime of the object
+	 * @param spread spread used when the spread calculation is disabled
+	 * @param balance initial balance
+	 */
+	BacktestControl(const IStockApi::MarketInfo &minfo,
+					PStatSvc &&statsvc,
+					Config config,
+					const ChartSoA::View &chart,
+					double spread,
+					double balance);
+	///Creates backtest over the chart - the chart must stay valid during lifetime of the object
+	BacktestControl(const IStockApi::MarketInfo &minfo,
+					PStatSvc &&statsvc,
 					Config config,
 					ondra_shared::StringView<IStatSvc::ChartItem> chart,
 					double spread,
@@ -33,6 +142,44 @@ public:
 
 	bool step();
 
+	///Returns the checkpoint - state of the trader and the broker
+	json::Value checkpoint() const;
+	///Continues from the checkpoint
+	/**
+	 * The checkpoint must be created on the same chart. The configuration can be
+	 * different, so multiple backtests can continue from a common checkpoint
+	 */
+	void resume(json::Value cp);
+	///Stores the checkpoint to the checkpoint_file (if set)
+	void saveCheckpoint();
+	///Loads the checkpoint from the file
+	/**
+	 * @return the checkpoint, or undefined value if the file doesn't exist
+	 */
+	static json::Value loadCheckpoint(const std::string &fname);
+	///Returns count of processed steps (including steps before the checkpoint)
+	std::size_t getSteps() const {return steps;}
+
+	///Returns result of the backtest so far
+	Result getResult() const;
+
+	///State of the account at current step
+	struct Sample {
+		std::uintptr_t time;
+		///value of the account (currency + position)
+		double equity;
+		///value of the position
+		double exposure;
+	};
+
+	///Returns state of the account at current step
+	Sample getSample() const;
+
+	///Returns true during the first half, when the chart is played backwards
+	/** Times of these steps are mirrored before the start of the chart, they
+	 * don't correspond to the real time */
+	bool isMirrored() const {return broker->isMirrored();}
+
 	static Config loadConfig(const std::string &fname,
 			const std::string &section,
 			const std::vector<ondra_shared::IniItem> &custom_options);
@@ -47,6 +194,14 @@ protected:
 
 	std::optional<MTrader> trader;
 
+	double peak_equity = 0;
+	double max_drawdown = 0;
+	std::size_t steps = 0;
+	std::string checkpoint_file;
+	std::size_t checkpoint_interval = 0;
+
+	void init(const IStockApi::MarketInfo &minfo, PStatSvc &&statsvc, Config &config, double spread, double balance);
+
 
 };
 
@@ -8,12 +8,44 @@
 
 #include "backtest_broker.h"
 
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+
 
 BacktestBroker::BacktestBroker(ondra_shared::StringView<IStatSvc::ChartItem> chart,
 		const MarketInfo &minfo, double balance)
-	:chart(chart),minfo(minfo),balance(balance),initial_balance(balance) {
-	pos = chart.length;
+	:source(chart),length(chart.length),minfo(minfo),balance(balance),initial_balance(balance) {
+	init();
+}
+
+BacktestBroker::BacktestBroker(const ChartSoA::View &chart,
+		const MarketInfo &minfo, double balance)
+	:chart(chart),length(chart.length),minfo(minfo),balance(balance),initial_balance(balance) {
+	init();
+}
+
+void BacktestBroker::init() {
+	pos = length;
 	back = true;
+	if (length) {
+		std::size_t l = local(0);
+		first_time = chart.time[l];
+		first_mid = chart.mid[l];
+		l = local(length-1);
+		cur_mid = chart.mid[l];
+	}
+}
+
+std::size_t BacktestBroker::local(std::size_t gpos) {
+	if (gpos < win_offset || gpos >= win_offset + chart.length) {
+		//only for the source chart, columns contain whole chart
+		std::size_t beg = back?(gpos+1 > chunkSize?gpos+1-chunkSize:0):gpos;
+		std::size_t cnt = std::min(chunkSize, length - beg);
+		owned_chart.assign(source.substr(beg, cnt));
+		chart = owned_chart.view();
+		win_offset = beg;
+	}
+	return gpos - win_offset;
 }
 
 BacktestBroker::TradeHistory BacktestBroker::getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view & pair) {
@@ -33,15 +65,18 @@ BacktestBroker::Orders BacktestBroker::getOpenOrders(const std::string_view & pa
 }
 
 BacktestBroker::Ticker BacktestBroker::getTicker(const std::string_view & piar) {
-	auto tm = chart[pos].time;
+	if (length == 0) throw std::runtime_error("Backtest: the chart is empty");
+	//before the first reset(), the position is after the end of the chart
+	std::size_t l = local(std::min<std::size_t>(pos, length-1));
+	auto tm = chart.time[l];
 	if (back) {
-		tm = 2*chart[0].time-tm;
+		tm = 2*first_time-tm;
 	}
 
 	return Ticker {
-		chart[pos].bid,
-		chart[pos].ask,
-		chart[pos].last,
+		chart.bid[l],
+		chart.ask[l],
+		chart.last[l],
 		tm
 	};
 }
@@ -69,20 +104,24 @@ bool BacktestBroker::reset() {
 	if (nx < 0) {
 		back = false;
 		return reset();
-	} else if (static_cast<unsigned int>(nx) >= chart.length) {
+	} else if (static_cast<std::size_t>(nx) >= length) {
 		return false;
 	}
 
 	pos = nx;
-	const IStatSvc::ChartItem &p = chart[pos];
+	std::size_t l = local(pos);
+	double bid = chart.bid[l];
+	double ask = chart.ask[l];
+	cur_mid = chart.mid[l];
 
 	auto txid = trades.size()+1;
-	auto tm = p.time;
+	auto tm = chart.time[l];
 	if (back) {
-		tm = 2*chart[0].time-tm;
+		tm = 2*first_time-tm;
 	}
+	cur_time = tm;
 
-	if (p.bid > sell.price && !sell_ex) {
+	if (bid > sell.price && !sell_ex) {
 		Trade tr;
 		tr.eff_price = sell.price;
 		tr.eff_size = sell.size;
@@ -97,7 +136,7 @@ bool BacktestBroker::reset() {
 		currency -= tr.eff_size*tr.eff_price;
 		sells++;
 	}
-	if (p.ask < buy.price && !buy_ex) {
+	if (ask < buy.price && !buy_ex) {
 		Trade tr;
 		tr.eff_price = buy.price;
 		tr.eff_size = buy.size;
@@ -121,3 +160,44 @@ double BacktestBroker::getBalance(const std::string_view & x) {
 	return balance;
 }
 
+
+json::Value BacktestBroker::exportState() const {
+	json::Array tr;
+	tr.reserve(trades.size());
+	for (auto &&t: trades) tr.push_back(t.toJSON());
+	return json::Object
+			("length", length)
+			("first_time", first_time)
+			("pos", pos)
+			("back", back)
+			("currency", currency)
+			("balance", balance)
+			("buys", buys)
+			("sells", sells)
+			("buy", buy_ex?json::Value():buy.toJSON())
+			("sell", sell_ex?json::Value():sell.toJSON())
+			("trades", tr);
+}
+
+void BacktestBroker::importState(json::Value st) {
+	if (st["length"].getUInt() != length || st["first_time"].getUInt() != first_time)
+		throw std::runtime_error("The checkpoint doesn't match the chart");
+	pos = st["pos"].getInt();
+	back = st["back"].getBool();
+	currency = st["currency"].getNumber();
+	balance = st["balance"].getNumber();
+	buys = st["buys"].getUInt();
+	sells = st["sells"].getUInt();
+	json::Value b = st["buy"], s = st["sell"];
+	buy_ex = !b.defined();
+	if (!buy_ex) buy = Order::fromJSON(b);
+	sell_ex = !s.defined();
+	if (!sell_ex) sell = Order::fromJSON(s);
+	trades.clear();
+	for (json::Value v: st["trades"]) trades.push_back(Trade::fromJSON(v));
+	if (static_cast<std::size_t>(pos) < length) {
+		std::size_t l = local(pos);
+		cur_mid = chart.mid[l];
+		cur_time = back?2*first_time-chart.time[l]:chart.time[l];
+	}
+}
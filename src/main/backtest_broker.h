@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <cmath>
 
 #include "../shared/stringview.h"
+#include "chart_soa.h"
 #include "istatsvc.h"
 #include "istockapi.h"
 
@@ -8,9 +10,24 @@
 class BacktestBroker: public IStockApi {
 public:
 
+	///Replays the chart
+	/**
+	 * The chart is not copied, it is converted to columns in chunks as the replay
+	 * advances, so the memory usage doesn't depend on the length of the chart. The chart
+	 * can be a memory mapped file (see MappedChartFile).
+	 *
+	 * The chart must stay valid during lifetime of the broker
+	 */
 	BacktestBroker(ondra_shared::StringView<IStatSvc::ChartItem> chart,
 			const MarketInfo &minfo,
 			double balance);
+	///Uses shared chart - the chart must stay valid during lifetime of the broker
+	BacktestBroker(const ChartSoA::View &chart,
+			const MarketInfo &minfo,
+			double balance);
+	BacktestBroker(const BacktestBroker &) = delete;
+	void operator=(const BacktestBroker &) = delete;
+
 	virtual TradeHistory getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view & pair) override;
 	virtual Orders getOpenOrders(const std::string_view & par) override;
 	virtual Ticker getTicker(const std::string_view & piar) override;
@@ -30,15 +47,52 @@ public:
 	virtual std::vector<std::string> getAllPairs() override {return {};}
 
 	double getScore() const {
-		return currency+sqrt(chart[0].bid*chart[0].ask)*balance;
+		return currency+first_mid*balance;
+	}
+	///Returns current value of the account (currency + assets at current price)
+	double getEquity() const {
+		return currency+cur_mid*balance;
+	}
+	///Returns value of the position at current price
+	double getExposure() const {
+		return balance*cur_mid;
+	}
+	///Returns time of the current step (the first half of the backtest is mirrored before the chart)
+	std::uintptr_t getTime() const {
+		return cur_time;
+	}
+	///Returns true while the chart is played backwards (the mirrored first half)
+	bool isMirrored() const {
+		return back;
 	}
 	unsigned int getTradeCount() const {
 		return std::min(buys,sells);
 	}
 
+	///Exports position in the chart, balances, orders and trades
+	json::Value exportState() const;
+	///Restores state exported by exportState() - the chart must be the same
+	void importState(json::Value st);
+
 protected:
+	///count of items converted at once, when the chart is not in columns
+	static constexpr std::size_t chunkSize = 16384;
+
 	double currency=0;
-	ondra_shared::StringView<IStatSvc::ChartItem> chart;
+	///source chart (if not in columns)
+	ondra_shared::StringView<IStatSvc::ChartItem> source;
+	///columns of the current chunk
+	ChartSoA owned_chart;
+	///current chunk of the chart (or whole chart)
+	ChartSoA::View chart;
+	///position of the chunk in the chart
+	std::size_t win_offset = 0;
+	///length of whole chart
+	std::size_t length;
+	std::uintptr_t first_time = 0;
+	double first_mid = 0;
+	double cur_mid = 0;
+	std::uintptr_t cur_time = 0;
 	TradeHistory trades;
 	Order buy, sell;
 	bool buy_ex = true, sell_ex = true;
@@ -49,4 +103,8 @@ protected:
 	double initial_balance;
 	unsigned int buys=0, sells=0;
 
+	void init();
+	///Converts position in the chart to index in the current chunk (loads chunk if needed)
+	std::size_t local(std::size_t gpos);
+
 };
@@ -14,6 +14,11 @@
 
 using ondra_shared::logDebug;
 
+//formula shared by the scalar and the batch function
+static inline double calc_price2balance(double price, double balance, double new_price) {
+	return balance*std::sqrt(price/new_price);
+}
+
 void Calculator::update(double new_price, double abs_balance) {
 
 
@@ -43,10 +48,20 @@ void Calculator::update_after_trade(double new_price, double new_balance, double
 double Calculator::price2balance(double new_price) const {
 
 	//basic formula to map price to balance
-	return balance*sqrt(price/new_price);
+	return calc_price2balance(price, balance, new_price);
 
 }
 
+void Calculator::price2balance(const Batch &calcs, const double *prices, double *out) {
+	const double * __restrict p = calcs.price;
+	const double * __restrict b = calcs.balance;
+	const double * __restrict in = prices;
+	double * __restrict o = out;
+	for (std::size_t i = 0; i < calcs.count; i++) {
+		o[i] = calc_price2balance(p[i], b[i], in[i]);
+	}
+}
+
 double Calculator::balance2price(double new_balance) const {
 
 	if (new_balance == 0) return 9e99;
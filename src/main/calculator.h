@@ -8,6 +8,8 @@
 #ifndef SRC_CALCULATOR_H_
 #define SRC_CALCULATOR_H_
 
+#include <cstddef>
+
 namespace json {
 	class Value;
 }
@@ -33,6 +35,21 @@ public:
 
 	double calcExtra(double prev_price, double new_price) const;
 
+	///States of multiple calculators stored as structure of arrays
+	struct Batch {
+		const double *price;
+		const double *balance;
+		std::size_t count;
+	};
+
+	///Batch version of price2balance() for multiple calculators
+	/**
+	 * Calculates out[i] as the result of the i-th calculator for prices[i]. The results
+	 * are equal to results of the scalar function. The loop is vectorized by the compiler,
+	 * the output array must not overlap the input arrays
+	 */
+	static void price2balance(const Batch &calcs, const double *prices, double *out);
+
 	json::Value toJSON() const;
 
 	static Calculator fromJSON(json::Value v);
@@ -0,0 +1,109 @@
+/*
+ * chart_file.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "chart_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static bool endsWith(const std::string &s, const char *suffix) {
+	std::size_t l = std::strlen(suffix);
+	return s.length() >= l && s.compare(s.length()-l, l, suffix) == 0;
+}
+
+static std::runtime_error fileError(const std::string &fname) {
+	return std::runtime_error("Chart file " + fname + ": " + std::strerror(errno));
+}
+
+MappedChartFile::MappedChartFile(const std::string &fname) {
+	std::string binname = fname;
+	if (endsWith(fname, ".csv")) {
+		binname = fname + ".bin";
+		struct stat csvst, binst;
+		if (::stat(fname.c_str(), &csvst)) throw fileError(fname);
+		if (::stat(binname.c_str(), &binst) || binst.st_mtime < csvst.st_mtime) {
+			convertCSV(fname, binname);
+		}
+	}
+
+	int fd = ::open(binname.c_str(), O_RDONLY);
+	if (fd < 0) throw fileError(binname);
+	struct stat st;
+	if (::fstat(fd, &st)) {
+		::close(fd);
+		throw fileError(binname);
+	}
+	mapsize = st.st_size;
+	if (mapsize % sizeof(ChartItem)) {
+		::close(fd);
+		throw std::runtime_error("Chart file " + binname + ": invalid size");
+	}
+	count = mapsize / sizeof(ChartItem);
+	if (count) {
+		void *p = ::mmap(nullptr, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			throw fileError(binname);
+		}
+		//the chart is read sequentially (in both directions)
+		::madvise(p, mapsize, MADV_SEQUENTIAL);
+		items = static_cast<const ChartItem *>(p);
+	}
+	::close(fd);
+}
+
+MappedChartFile::~MappedChartFile() {
+	if (items) ::munmap(const_cast<ChartItem *>(items), mapsize);
+}
+
+std::size_t MappedChartFile::convertCSV(const std::string &csv, const std::string &bin) {
+	std::ifstream in(csv);
+	if (!in) throw fileError(csv);
+	std::string tmpname = bin + ".tmp";
+	std::ofstream out(tmpname, std::ios::binary|std::ios::trunc);
+	if (!out) throw fileError(tmpname);
+
+	std::string line;
+	std::size_t cnt = 0;
+	while (std::getline(in, line)) {
+		const char *c = line.c_str();
+		while (*c && std::isspace(static_cast<unsigned char>(*c))) c++;
+		if (!std::isdigit(static_cast<unsigned char>(*c))) continue;
+		double vals[4];
+		int n = 0;
+		while (n < 4 && *c) {
+			char *e;
+			vals[n] = std::strtod(c, &e);
+			if (e == c) break;
+			n++;
+			c = e;
+			while (*c && (std::isspace(static_cast<unsigned char>(*c)) || *c == ',' || *c == ';')) c++;
+		}
+		ChartItem itm;
+		if (n == 2) {
+			itm = ChartItem{static_cast<std::uintptr_t>(vals[0]), vals[1], vals[1], vals[1]};
+		} else if (n == 4) {
+			itm = ChartItem{static_cast<std::uintptr_t>(vals[0]), vals[1], vals[2], vals[3]};
+		} else {
+			continue;
+		}
+		out.write(reinterpret_cast<const char *>(&itm), sizeof(itm));
+		cnt++;
+	}
+	out.close();
+	if (!out) throw fileError(tmpname);
+	if (std::rename(tmpname.c_str(), bin.c_str())) throw fileError(bin);
+	return cnt;
+}
@@ -0,0 +1,57 @@
+/*
+ * chart_file.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_CHART_FILE_H_
+#define SRC_MAIN_CHART_FILE_H_
+
+#include <string>
+
+#include "../shared/stringview.h"
+#include "istatsvc.h"
+
+///Chart stored in a file, mapped to the memory
+/**
+ * The binary file is an array of ChartItem records (time, ask, bid, last - native
+ * layout, without a header). The file is mapped to the memory, so the chart is
+ * read from the disk as it is replayed and the memory usage doesn't depend on the
+ * size of the file.
+ *
+ * A CSV file (extension .csv) is converted to the binary file first. The binary file
+ * is created next to the CSV file (<name>.csv.bin) and it is reused until the CSV file
+ * is changed. Expected columns are: time (in milliseconds), ask, bid, last. When
+ * only two columns are present, the second column is used as all three prices. Lines
+ * which don't start by a number (header) are skipped.
+ */
+class MappedChartFile {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+
+	explicit MappedChartFile(const std::string &fname);
+	~MappedChartFile();
+	MappedChartFile(const MappedChartFile &) = delete;
+	void operator=(const MappedChartFile &) = delete;
+
+	ondra_shared::StringView<ChartItem> getChart() const {
+		return ondra_shared::StringView<ChartItem>(items, count);
+	}
+
+	///Converts CSV file to the binary file
+	/**
+	 * @param csv source file
+	 * @param bin target file
+	 * @return count of items written
+	 */
+	static std::size_t convertCSV(const std::string &csv, const std::string &bin);
+
+protected:
+	const ChartItem *items = nullptr;
+	std::size_t count = 0;
+	std::size_t mapsize = 0;
+};
+
+
+#endif /* SRC_MAIN_CHART_FILE_H_ */
@@ -0,0 +1,62 @@
+/*
+ * chart_soa.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "chart_soa.h"
+
+#include <cmath>
+
+void ChartSoA::assign(ondra_shared::StringView<ChartItem> chart) {
+	std::size_t cnt = chart.length;
+	time.resize(cnt);
+	ask.resize(cnt);
+	bid.resize(cnt);
+	last.resize(cnt);
+	mid.resize(cnt);
+	logmid.resize(cnt);
+
+	//split columns
+	for (std::size_t i = 0; i < cnt; i++) {
+		const ChartItem &itm = chart[i];
+		time[i] = itm.time;
+		ask[i] = itm.ask;
+		bid[i] = itm.bid;
+		last[i] = itm.last;
+	}
+	//column loops - these can be vectorized
+	const double * __restrict a = ask.data();
+	const double * __restrict b = bid.data();
+	double * __restrict m = mid.data();
+	double * __restrict lm = logmid.data();
+	for (std::size_t i = 0; i < cnt; i++) {
+		m[i] = std::sqrt(a[i]*b[i]);
+	}
+	for (std::size_t i = 0; i < cnt; i++) {
+		lm[i] = std::log(m[i]);
+	}
+}
+
+void ChartSoA::push_back(const ChartItem &itm) {
+	double m = std::sqrt(itm.ask*itm.bid);
+	time.push_back(itm.time);
+	ask.push_back(itm.ask);
+	bid.push_back(itm.bid);
+	last.push_back(itm.last);
+	mid.push_back(m);
+	logmid.push_back(std::log(m));
+}
+
+void ChartSoA::clear() {
+	time.clear();
+	ask.clear();
+	bid.clear();
+	last.clear();
+	mid.clear();
+	logmid.clear();
+}
+
+ChartSoA::View ChartSoA::view() const {
+	return View{time.data(), ask.data(), bid.data(), last.data(), mid.data(), logmid.data(), time.size()};
+}
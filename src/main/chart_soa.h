@@ -0,0 +1,96 @@
+/*
+ * chart_soa.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_CHART_SOA_H_
+#define SRC_MAIN_CHART_SOA_H_
+
+#include <new>
+#include <vector>
+
+#include "../shared/stringview.h"
+#include "istatsvc.h"
+
+///Allocator which aligns the memory for SIMD loads
+template<typename T, std::size_t alignment = 32>
+class AlignedAllocator {
+public:
+	using value_type = T;
+
+	template<typename U> struct rebind {using other = AlignedAllocator<U, alignment>;};
+
+	AlignedAllocator() {}
+	template<typename U> AlignedAllocator(const AlignedAllocator<U, alignment> &) {}
+
+	T *allocate(std::size_t n) {
+		return static_cast<T *>(::operator new(n*sizeof(T), std::align_val_t(alignment)));
+	}
+	void deallocate(T *ptr, std::size_t) {
+		::operator delete(ptr, std::align_val_t(alignment));
+	}
+	template<typename U> bool operator==(const AlignedAllocator<U, alignment> &) const {return true;}
+	template<typename U> bool operator!=(const AlignedAllocator<U, alignment> &) const {return false;}
+};
+
+template<typename T> using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+
+///Chart stored as structure of arrays
+/**
+ * Every column is stored in its own contiguous aligned array. The mid price (sqrt(ask*bid))
+ * and its logarithm are calculated once while the chart is built, so the consumers don't need
+ * to recalculate it for every point. Loops over columns can be vectorized by the compiler
+ */
+class ChartSoA {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+
+	///Read only view to the chart (or to its part)
+	struct View {
+		const std::uintptr_t *time = nullptr;
+		const double *ask = nullptr;
+		const double *bid = nullptr;
+		const double *last = nullptr;
+		const double *mid = nullptr;
+		const double *logmid = nullptr;
+		std::size_t length = 0;
+
+		bool empty() const {return length == 0;}
+		View substr(std::size_t pos) const {
+			if (pos > length) pos = length;
+			return View{time+pos, ask+pos, bid+pos, last+pos, mid+pos, logmid+pos, length-pos};
+		}
+		View substr(std::size_t pos, std::size_t len) const {
+			View res = substr(pos);
+			if (len < res.length) res.length = len;
+			return res;
+		}
+		ChartItem operator[](std::size_t idx) const {
+			return ChartItem{time[idx], ask[idx], bid[idx], last[idx]};
+		}
+	};
+
+	ChartSoA() {}
+	explicit ChartSoA(ondra_shared::StringView<ChartItem> chart) {assign(chart);}
+
+	void assign(ondra_shared::StringView<ChartItem> chart);
+	void push_back(const ChartItem &itm);
+	void clear();
+	std::size_t size() const {return time.size();}
+
+	View view() const;
+
+protected:
+	AlignedVector<std::uintptr_t> time;
+	AlignedVector<double> ask;
+	AlignedVector<double> bid;
+	AlignedVector<double> last;
+	AlignedVector<double> mid;
+	AlignedVector<double> logmid;
+};
+
+
+
+#endif /* SRC_MAIN_CHART_SOA_H_ */
@@ -0,0 +1,151 @@
+/*
+ * chart_tiers.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "chart_tiers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <imtjson/value.h>
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+
+ChartTiers::ChartTiers(std::size_t history_days)
+	:ChartTiers({
+		{15, std::min<std::size_t>(history_days, 30)*96},
+		{60, history_days*24}
+	}) {}
+
+ChartTiers::ChartTiers(std::vector<TierDef> defs) {
+	for (auto &&d: defs) {
+		if (d.minutes && d.capacity) tiers.push_back(Tier{d,{}});
+	}
+}
+
+bool ChartTiers::update(Tier &t, const ChartItem &itm) {
+	std::uintptr_t period = static_cast<std::uintptr_t>(t.def.minutes)*60000;
+	std::uintptr_t btime = itm.time - itm.time % period;
+	double mid = std::sqrt(itm.ask*itm.bid);
+
+	if (t.bars.empty() || t.bars.back().time != btime) {
+		//time goes backward (restored old state) - ignore the item
+		if (!t.bars.empty() && t.bars.back().time > btime) return false;
+		bool closed = !t.bars.empty();
+		t.bars.push_back(Bar{
+			btime, mid, mid, mid, mid,
+			itm.bid, itm.ask, itm.bid, itm.ask, itm.last
+		});
+		//trim in batches, so the cost of the erase is amortized
+		if (t.bars.size() > 2*t.def.capacity) {
+			t.bars.erase(t.bars.begin(), t.bars.end()-t.def.capacity);
+		}
+		return closed;
+	} else {
+		Bar &b = t.bars.back();
+		b.high = std::max(b.high, mid);
+		b.low = std::min(b.low, mid);
+		b.close = mid;
+		b.bid_high = std::max(b.bid_high, itm.bid);
+		b.ask_low = std::min(b.ask_low, itm.ask);
+		b.bid = itm.bid;
+		b.ask = itm.ask;
+		b.last = itm.last;
+		return false;
+	}
+}
+
+bool ChartTiers::push(const ChartItem &itm) {
+	bool closed = false;
+	for (auto &&t: tiers) closed = update(t, itm) || closed;
+	return closed;
+}
+
+void ChartTiers::catchUp(ondra_shared::StringView<ChartItem> chart) {
+	for (auto &&t: tiers) {
+		std::uintptr_t from = t.bars.empty()?0:t.bars.back().time;
+		for (auto &&itm: chart) {
+			if (itm.time >= from) update(t, itm);
+		}
+	}
+}
+
+ondra_shared::StringView<ChartTiers::Bar> ChartTiers::getTier(std::size_t idx) const {
+	const Tier &t = tiers[idx];
+	ondra_shared::StringView<Bar> bars(t.bars.data(), t.bars.size());
+	if (bars.length > t.def.capacity) bars = bars.substr(bars.length - t.def.capacity);
+	return bars;
+}
+
+int ChartTiers::findTier(unsigned int minutes) const {
+	for (std::size_t i = 0; i < tiers.size(); i++) {
+		if (tiers[i].def.minutes == minutes) return static_cast<int>(i);
+	}
+	return -1;
+}
+
+std::vector<ChartTiers::ChartItem> ChartTiers::toChart(std::size_t idx) const {
+	auto bars = getTier(idx);
+	std::uintptr_t period = static_cast<std::uintptr_t>(tiers[idx].def.minutes)*60000;
+	std::vector<ChartItem> res;
+	res.reserve(bars.length*3);
+	for (auto &&b: bars) {
+		double rs = b.ask/b.bid;
+		ChartItem low{0, b.ask_low, b.ask_low/rs, std::sqrt(b.ask_low*b.ask_low/rs)};
+		ChartItem high{0, b.bid_high*rs, b.bid_high, std::sqrt(b.bid_high*b.bid_high*rs)};
+		ChartItem &first = b.close >= b.open?low:high;
+		ChartItem &second = b.close >= b.open?high:low;
+		first.time = b.time;
+		second.time = b.time + period/2;
+		res.push_back(first);
+		res.push_back(second);
+		res.push_back(ChartItem{b.time + period - 60000, b.ask, b.bid, b.last});
+	}
+	return res;
+}
+
+bool ChartTiers::empty() const {
+	return std::all_of(tiers.begin(), tiers.end(), [](const Tier &t){
+		return t.bars.empty();
+	});
+}
+
+json::Value ChartTiers::toJSON() const {
+	json::Array res;
+	for (std::size_t i = 0; i < tiers.size(); i++) {
+		json::Array bars;
+		for (auto &&b: getTier(i)) {
+			bars.push_back(json::Value(json::array, {b.time, b.open, b.high, b.low, b.close,
+				b.bid_high, b.ask_low, b.bid, b.ask, b.last}));
+		}
+		res.push_back(json::Object("m", tiers[i].def.minutes)("b", bars));
+	}
+	return res;
+}
+
+void ChartTiers::fromJSON(json::Value v) {
+	for (json::Value t: v) {
+		int idx = findTier(t["m"].getUInt());
+		if (idx < 0) continue;
+		Tier &tier = tiers[idx];
+		tier.bars.clear();
+		for (json::Value b: t["b"]) {
+			tier.bars.push_back(Bar{
+				b[0].getUInt(),
+				b[1].getNumber(),
+				b[2].getNumber(),
+				b[3].getNumber(),
+				b[4].getNumber(),
+				b[5].getNumber(),
+				b[6].getNumber(),
+				b[7].getNumber(),
+				b[8].getNumber(),
+				b[9].getNumber()
+			});
+		}
+		if (tier.bars.size() > tier.def.capacity) {
+			tier.bars.erase(tier.bars.begin(), tier.bars.end()-tier.def.capacity);
+		}
+	}
+}
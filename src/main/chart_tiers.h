@@ -0,0 +1,125 @@
+/*
+ * chart_tiers.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_CHART_TIERS_H_
+#define SRC_MAIN_CHART_TIERS_H_
+
+#include <vector>
+
+#include "../shared/stringview.h"
+#include "istatsvc.h"
+
+namespace json {
+	class Value;
+}
+
+///Downsampled chart kept in several resolutions (tiers)
+/**
+ * Every tier contains OHLC bars of a fixed period. Bars are updated incrementally
+ * as new chart items arrive, so a long history can be kept at bounded memory. Each tier
+ * has its own capacity, older bars are dropped
+ */
+class ChartTiers {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+
+	///One bar of the tier
+	struct Bar {
+		///time of the first item in the bar
+		std::uintptr_t time;
+		///mid price (sqrt(ask*bid)) - open
+		double open;
+		///mid price - high
+		double high;
+		///mid price - low
+		double low;
+		///mid price - close
+		double close;
+		///highest bid seen during the bar (can fill a sell order)
+		double bid_high;
+		///lowest ask seen during the bar (can fill a buy order)
+		double ask_low;
+		///closing bid
+		double bid;
+		///closing ask
+		double ask;
+		///closing last price
+		double last;
+	};
+
+	struct TierDef {
+		///length of the bar in minutes
+		unsigned int minutes;
+		///count of bars kept
+		std::size_t capacity;
+	};
+
+	///Creates standard tiers 15m, 1h
+	/**
+	 * The 1 minute resolution is not kept, it is the chart of the trader itself
+	 *
+	 * @param history_days count of days kept in the 1 hour tier. The 15 minutes
+	 * tier holds at most 30 days
+	 */
+	explicit ChartTiers(std::size_t history_days);
+	ChartTiers(std::vector<TierDef> defs);
+
+	///Adds new item to the all tiers
+	/**
+	 * @retval true a bar of some tier has been closed (new bar started)
+	 * @retval false all items were added to the current bars
+	 */
+	bool push(const ChartItem &itm);
+	///Adds items newer than the last bar of each tier
+	/** Used after the tiers are loaded to rebuild the current bars from the chart */
+	void catchUp(ondra_shared::StringView<ChartItem> chart);
+
+	///Returns count of tiers
+	std::size_t size() const {return tiers.size();}
+
+	///Returns bars of the tier
+	ondra_shared::StringView<Bar> getTier(std::size_t idx) const;
+	///Finds tier by its period
+	/**
+	 * @param minutes period in minutes
+	 * @return index of the tier or -1 if not found
+	 */
+	int findTier(unsigned int minutes) const;
+	///Converts tier to chart items
+	/** Every bar is converted to three items - both extremes (lowest ask, highest bid)
+	 * and the close. The extremes are ordered by the usual OHLC path (a rising bar visits
+	 * the low first). The extremes keep the closing spread. It allows to use the tier as chart
+	 * for spread calculation and backtests, orders which would be filled inside of the bar
+	 * are filled.
+	 *
+	 * @param idx index of the tier
+	 * @return chart
+	 */
+	std::vector<ChartItem> toChart(std::size_t idx) const;
+
+	json::Value toJSON() const;
+	///Loads tiers from the JSON. Tiers are matched by their period
+	void fromJSON(json::Value v);
+
+	bool empty() const;
+
+protected:
+
+	struct Tier {
+		TierDef def;
+		std::vector<Bar> bars;
+	};
+
+	std::vector<Tier> tiers;
+
+	///returns true, when new bar has been started
+	static bool update(Tier &t, const ChartItem &itm);
+};
+
+
+
+#endif /* SRC_MAIN_CHART_TIERS_H_ */
@@ -0,0 +1,42 @@
+/*
+ * event_queue.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "event_queue.h"
+
+bool EventQueue::push(const PMsg &msg) {
+	std::lock_guard<std::mutex> _(lock);
+	if (closed) return false;
+	if (msgs.size() >= capacity) {
+		closed = true;
+		msgs.clear();
+		cond.notify_all();
+		return false;
+	}
+	msgs.push_back(msg);
+	cond.notify_all();
+	return true;
+}
+
+bool EventQueue::pop(std::vector<PMsg> &out) {
+	std::unique_lock<std::mutex> lk(lock);
+	cond.wait(lk, [&]{return closed || !msgs.empty();});
+	if (closed) return false;
+	out.insert(out.end(), msgs.begin(), msgs.end());
+	msgs.clear();
+	return true;
+}
+
+bool EventQueue::isClosed() const {
+	std::lock_guard<std::mutex> _(lock);
+	return closed;
+}
+
+void EventQueue::close() {
+	std::lock_guard<std::mutex> _(lock);
+	closed = true;
+	msgs.clear();
+	cond.notify_all();
+}
@@ -0,0 +1,63 @@
+/*
+ * event_queue.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_EVENT_QUEUE_H_
+#define SRC_MAIN_EVENT_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+///Bounded queue of formatted server-sent events of a single client
+/**
+ * The producer (trading thread, logging) only pushes messages to the queue and never
+ * blocks on the socket. The socket is written by the consumer (writer thread of the
+ * stream). When the client doesn't read fast enough and the queue becomes full, the queue
+ * is closed and the client is disconnected
+ */
+class EventQueue {
+public:
+
+	static constexpr std::size_t capacity = 256;
+
+	///Message is shared by queues of all clients
+	using PMsg = std::shared_ptr<const std::string>;
+
+	///Pushes the message
+	/**
+	 * @param msg message
+	 * @retval true pushed
+	 * @retval false queue is closed, or it was full and it has been closed now
+	 */
+	bool push(const PMsg &msg);
+
+	///Waits for messages and moves them to the output
+	/**
+	 * @param out receives all pending messages
+	 * @retval true messages has been received
+	 * @retval false queue is closed
+	 */
+	bool pop(std::vector<PMsg> &out);
+
+	///Closes the queue, wakes up the consumer
+	void close();
+
+	///Returns true, if the queue is closed
+	bool isClosed() const;
+
+protected:
+	mutable std::mutex lock;
+	std::condition_variable cond;
+	std::deque<PMsg> msgs;
+	bool closed = false;
+};
+
+using PEventQueue = std::shared_ptr<EventQueue>;
+
+#endif /* SRC_MAIN_EVENT_QUEUE_H_ */
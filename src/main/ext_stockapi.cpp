@@ -10,6 +10,7 @@
 
 #include "ext_stockapi.h"
 
+#include <imtjson/array.h>
 #include <imtjson/object.h>
 
 using namespace ondra_shared;
@@ -78,6 +79,61 @@ json::Value  ExtStockApi::placeOrder(const std::string_view & pair,
 }
 
 
+std::vector<ExtStockApi::OrderResult> ExtStockApi::placeOrders(const std::vector<OrderRequest> &orders) {
+	if (!batch_supported || orders.size() < 2) return IStockApi::placeOrders(orders);
+
+	json::Array req;
+	req.reserve(orders.size());
+	for (auto &&o: orders) {
+		req.push_back(json::Object
+				("pair",StrViewA(o.pair))
+				("price",o.price)
+				("size",o.size)
+				("clientOrderId",o.clientId)
+				("replaceOrderId",o.replaceId)
+				("replaceOrderSize",o.replaceSize));
+	}
+
+	json::Value results;
+	std::string error;
+	try {
+		json::Value resp = jsonExchange({"placeOrders", req});
+		if (resp[0].getBool() != true) {
+			json::Value err = resp[1];
+			//older brokers - nothing has been placed, so place orders one by one
+			if (!err.defined() || err.getString() == "Method not implemented") {
+				batch_supported = false;
+				return IStockApi::placeOrders(orders);
+			}
+			error = err.toString().str();
+		} else if (resp[1].type() == json::array && resp[1].size() == orders.size()) {
+			results = resp[1];
+		} else {
+			//the broker can't be trusted with the batch anymore. The orders may have
+			//been placed, so they are not resent, the next cycle places them one by one
+			log.warning("placeOrders returned malformed response, disabled: $1", resp.toString().str());
+			batch_supported = false;
+			error = "Malformed response of placeOrders";
+		}
+	} catch (std::exception &e) {
+		//timeout or lost connection - the orders may have been placed, so they are
+		//not resent. The batch remains enabled
+		error = e.what();
+	}
+	if (!results.defined()) {
+		//whole request failed, so all orders failed
+		return std::vector<OrderResult>(orders.size(), OrderResult{json::Value(), error});
+	}
+
+	std::vector<OrderResult> res;
+	res.reserve(orders.size());
+	for (json::Value r: results) {
+		if (r[0].getBool()) res.push_back(OrderResult{r[1], std::string()});
+		else res.push_back(OrderResult{json::Value(), std::string(r[1].toString().str())});
+	}
+	return res;
+}
+
 bool ExtStockApi::reset() {
 	if (chldid != -1) try {
 		jsonRequestExchange("reset",json::Value());
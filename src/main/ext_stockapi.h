@@ -27,6 +27,7 @@ public:
 	virtual json::Value placeOrder(const std::string_view & pair,
 			double size, double price,json::Value clientId,
 			json::Value replaceId,double replaceSize) override;
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders) override;
 	virtual bool reset() override;
 	virtual bool isTest() const override {return false;}
 	virtual MarketInfo getMarketInfo(const std::string_view & pair) override;
@@ -35,6 +36,10 @@ public:
 	virtual void testBroker() override {preload();}
 	virtual void onConnect() override;
 
+protected:
+	///set to false when the batch call placeOrders fails (for any reason)
+	bool batch_supported = true;
+
 };
 
 
@@ -0,0 +1,29 @@
+/*
+ * gzip.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "gzip.h"
+
+#include <stdexcept>
+#include <zlib.h>
+
+std::string gzipCompress(std::string_view data) {
+	z_stream strm = {};
+	//15+16 - max window with gzip header
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15+16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		throw std::runtime_error("Failed to initialize zlib");
+
+	std::string out;
+	out.resize(deflateBound(&strm, data.size()));
+	strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+	strm.avail_in = data.size();
+	strm.next_out = reinterpret_cast<Bytef *>(out.data());
+	strm.avail_out = out.size();
+	int r = deflate(&strm, Z_FINISH);
+	deflateEnd(&strm);
+	if (r != Z_STREAM_END) throw std::runtime_error("Failed to compress data");
+	out.resize(strm.total_out);
+	return out;
+}
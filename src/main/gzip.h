@@ -0,0 +1,16 @@
+/*
+ * gzip.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_GZIP_H_
+#define SRC_MAIN_GZIP_H_
+
+#include <string>
+#include <string_view>
+
+///Compresses the data to the gzip format (suitable for Content-Encoding: gzip)
+std::string gzipCompress(std::string_view data);
+
+#endif /* SRC_MAIN_GZIP_H_ */
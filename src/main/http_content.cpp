@@ -0,0 +1,251 @@
+/*
+ * http_content.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "http_content.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <experimental/filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+#include <simpleServer/query_parser.h>
+
+#include "gzip.h"
+#include "report.h"
+
+using ondra_shared::StrViewA;
+using simpleServer::HTTPRequest;
+using simpleServer::HTTPResponse;
+
+std::string ReportHttpHandler::stripQuery(StrViewA path) {
+	std::string_view p(path.data, path.length);
+	auto q = p.find('?');
+	if (q != p.npos) p = p.substr(0,q);
+	return std::string(p);
+}
+
+void ReportHttpHandler::sendContent(HTTPRequest req,
+		const std::string &contentType,
+		const std::string &etag,
+		const std::string &content,
+		const std::string &gzip,
+		const char *cacheControl) {
+
+	StrViewA inm = req["If-None-Match"];
+	if (inm == StrViewA(etag)) {
+		req.sendResponse(HTTPResponse(304)
+				("ETag",etag)
+				("Cache-Control",cacheControl), StrViewA());
+		return;
+	}
+	StrViewA ae = req["Accept-Encoding"];
+	bool usegz = !gzip.empty() && std::string_view(ae.data, ae.length).find("gzip") != std::string_view::npos;
+	HTTPResponse resp(200);
+	resp.contentType(contentType)
+			("ETag",etag)
+			("Cache-Control",cacheControl)
+			("Vary","Accept-Encoding");
+	if (usegz) {
+		resp("Content-Encoding","gzip");
+		req.sendResponse(std::move(resp), StrViewA(gzip));
+	} else {
+		req.sendResponse(std::move(resp), StrViewA(content));
+	}
+}
+
+void ReportHttpHandler::operator()(HTTPRequest req) const {
+	std::string path = stripQuery(req.getPath());
+	Report::PPublished p;
+	if (path == "/report.json") {
+		p = rpt.getPublishedReport();
+	} else if (path == "/report_delta.json") {
+		p = rpt.getPublishedDelta();
+	} else if (path == "/report_index.json") {
+		p = rpt.getPublishedIndex();
+	} else if (path.compare(0, 7, "/shard_") == 0) {
+		p = rpt.getPublishedShard(path.substr(1));
+		if (p == nullptr) {
+			req.sendErrorPage(404);
+			return;
+		}
+	} else if (path == "/api/trades") {
+		queryTrades(req);
+		return;
+	} else if (path == "/api/log") {
+		simpleServer::QueryParser qp(req.getPath());
+		StrViewA since = qp["since"];
+		json::Array lines;
+		std::uint64_t seq = since.empty()?0:std::strtoull(std::string(since).c_str(), nullptr, 10);
+		//sequence from previous run of the robot
+		if (seq > rpt.getLogSeq()) seq = 0;
+		for (auto &&ln: rpt.getLog(seq)) {
+			lines.push_back(json::Object("seq", ln.seq)("line", ln.text));
+			seq = ln.seq;
+		}
+		json::Value res = json::Object("seq", seq)("lines", lines);
+		std::string content(res.stringify().str());
+		req.sendResponse(HTTPResponse(200)
+				.contentType("application/json")
+				("Cache-Control","no-cache"), StrViewA(content));
+		return;
+	} else if (path == "/api/stream") {
+		//every stream has own writer thread, so count of streams is limited
+		auto q = std::make_shared<EventQueue>();
+		if (!rpt.addStream(q)) {
+			req.sendErrorPage(503);
+			return;
+		}
+		simpleServer::Stream s = req.sendResponse(HTTPResponse(200)
+				.contentType("text/event-stream")
+				("Cache-Control","no-cache"));
+		s << "retry: 10000\n\n";
+		if (!s.flush()) {
+			q->close();
+			return;
+		}
+		//the stream is written by its own thread, so a slow client never blocks
+		//the thread which generates events
+		std::thread([s, q]() mutable {
+			std::vector<EventQueue::PMsg> msgs;
+			while (q->pop(msgs)) {
+				for (auto &&m: msgs) s << *m;
+				msgs.clear();
+				if (!s.flush()) break;
+			}
+			q->close();
+		}).detach();
+		return;
+	} else {
+		next(req);
+		return;
+	}
+	if (p == nullptr) {
+		//report is not ready yet
+		req.sendErrorPage(503);
+	} else {
+		sendContent(req, "application/json", p->etag, p->content, p->gzip, "no-cache");
+	}
+}
+
+void ReportHttpHandler::queryTrades(HTTPRequest req) const {
+	simpleServer::QueryParser qp(req.getPath());
+	auto getNum = [&](StrViewA name, std::uint64_t def) -> std::uint64_t {
+		StrViewA v = qp[name];
+		if (v.empty()) return def;
+		return std::strtoull(std::string(v).c_str(), nullptr, 10);
+	};
+
+	Report::PTradeIndex idx = rpt.getTradeIndex(qp["symb"]);
+	if (idx == nullptr) {
+		req.sendErrorPage(404);
+		return;
+	}
+	std::uint64_t from = getNum("from", 0);
+	std::uint64_t to = getNum("to", std::numeric_limits<std::uint64_t>::max());
+	StrViewA agg = qp["agg"];
+	json::Value res;
+	if (agg.empty()) {
+		std::size_t offset = getNum("offset", 0);
+		std::size_t limit = std::min<std::uint64_t>(getNum("limit", 1000), 10000);
+		res = idx->query(from, to, offset, limit);
+	} else {
+		std::uint64_t period;
+		if (agg == "hour") period = 3600000;
+		else if (agg == "day") period = 86400000;
+		else {
+			req.sendErrorPage(400);
+			return;
+		}
+		res = idx->aggregate(from, to, period);
+	}
+	std::string content(res.stringify().str());
+	req.sendResponse(HTTPResponse(200)
+			.contentType("application/json")
+			("Cache-Control","no-cache"), StrViewA(content));
+}
+
+CachedFileMapper::CachedFileMapper(std::string path, std::string index)
+	:cache(std::make_shared<Cache>()),path(path),index(index) {}
+
+const char *CachedFileMapper::contentTypeFromName(const std::string &fname, bool &text) {
+	static const std::pair<const char *, const char *> types[] = {
+			{".html","text/html;charset=utf-8"},
+			{".js","application/javascript"},
+			{".css","text/css"},
+			{".svg","image/svg+xml"},
+			{".json","application/json"},
+			{".png","image/png"},
+			{".ico","image/x-icon"},
+			{".jpg","image/jpeg"},
+	};
+	for (auto &&t: types) {
+		std::string_view ext(t.first);
+		if (fname.size() > ext.size() && fname.compare(fname.size()-ext.size(), ext.size(), ext) == 0) {
+			text = std::string_view(t.second).find("image/") != 0 || ext == ".svg";
+			return t.second;
+		}
+	}
+	text = false;
+	return "application/octet-stream";
+}
+
+CachedFileMapper::PEntry CachedFileMapper::loadFile(const std::string &fname, std::size_t mtime) const {
+	std::ifstream f(fname, std::ios::in|std::ios::binary);
+	if (!f) return nullptr;
+	std::ostringstream buff;
+	buff << f.rdbuf();
+	auto e = std::make_shared<Entry>();
+	bool text;
+	e->contentType = contentTypeFromName(fname, text);
+	e->content = buff.str();
+	e->mtime = mtime;
+	e->etag = "\""+std::to_string(mtime)+"-"+std::to_string(e->content.size())+"\"";
+	if (text) e->gzip = gzipCompress(e->content);
+	return e;
+}
+
+void CachedFileMapper::operator()(HTTPRequest req) const {
+	namespace fs = std::experimental::filesystem;
+
+	std::string p = ReportHttpHandler::stripQuery(req.getPath());
+	if (p.find("..") != p.npos) {
+		req.sendErrorPage(403);
+		return;
+	}
+	if (p.empty() || p.back() == '/') p.append(index);
+	std::string fname = path+p;
+
+	std::error_code ec;
+	auto ftime = fs::last_write_time(fname, ec);
+	if (ec || fs::is_directory(fname, ec)) {
+		req.sendErrorPage(404);
+		return;
+	}
+	std::size_t mtime = std::chrono::duration_cast<std::chrono::seconds>(ftime.time_since_epoch()).count();
+
+	PEntry e;
+	{
+		std::lock_guard<std::mutex> _(cache->lock);
+		auto iter = cache->files.find(p);
+		if (iter != cache->files.end() && iter->second->mtime == mtime) e = iter->second;
+	}
+	if (e == nullptr) {
+		e = loadFile(fname, mtime);
+		if (e == nullptr) {
+			req.sendErrorPage(404);
+			return;
+		}
+		std::lock_guard<std::mutex> _(cache->lock);
+		cache->files[p] = e;
+	}
+	ReportHttpHandler::sendContent(req, e->contentType, e->etag, e->content, e->gzip, "no-cache");
+}
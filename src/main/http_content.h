@@ -0,0 +1,101 @@
+/*
+ * http_content.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_HTTP_CONTENT_H_
+#define SRC_MAIN_HTTP_CONTENT_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <simpleServer/http_server.h>
+
+class Report;
+
+///Serves the report and the delta report directly from the memory
+/**
+ * Path /api/trades allows to query the trade history (see queryTrades()).
+ *
+ * Path /api/stream opens server-sent events stream, which pushes changes of the report
+ * as they happen.
+ *
+ * Requests for other paths are passed to the next handler
+ */
+class ReportHttpHandler {
+public:
+	ReportHttpHandler(Report &rpt, simpleServer::HTTPHandler &&next):rpt(rpt),next(std::move(next)) {}
+
+	void operator()(simpleServer::HTTPRequest req) const;
+
+	///Sends content with ETag, handles If-None-Match, uses gzip version when client accepts it
+	/**
+	 * @param req request
+	 * @param contentType content type
+	 * @param etag etag (including quotes)
+	 * @param content uncompressed content
+	 * @param gzip compressed content, can be empty, if not available
+	 * @param cacheControl value of Cache-Control header
+	 */
+	static void sendContent(simpleServer::HTTPRequest req,
+			const std::string &contentType,
+			const std::string &etag,
+			const std::string &content,
+			const std::string &gzip,
+			const char *cacheControl);
+
+	///Returns path without query
+	static std::string stripQuery(ondra_shared::StrViewA path);
+
+protected:
+	Report &rpt;
+	simpleServer::HTTPHandler next;
+
+	///Handles /api/trades
+	/**
+	 * Query arguments: symb (mandatory), from, to (time in milliseconds), offset, limit
+	 * (paging) and agg (hour or day - returns aggregated statistics instead of trades)
+	 */
+	void queryTrades(simpleServer::HTTPRequest req) const;
+};
+
+///Serves static files from the memory
+/**
+ * Files are loaded on the first request and kept in the memory. The file is reloaded
+ * only when its modification time changes. Text files are kept also compressed
+ */
+class CachedFileMapper {
+public:
+	CachedFileMapper(std::string path, std::string index);
+
+	void operator()(simpleServer::HTTPRequest req) const;
+
+protected:
+
+	struct Entry {
+		std::string contentType;
+		std::string etag;
+		std::string content;
+		std::string gzip;
+		std::size_t mtime;
+	};
+
+	using PEntry = std::shared_ptr<const Entry>;
+
+	struct Cache {
+		std::mutex lock;
+		std::map<std::string, PEntry> files;
+	};
+
+	std::shared_ptr<Cache> cache;
+	std::string path;
+	std::string index;
+
+	PEntry loadFile(const std::string &fname, std::size_t mtime) const;
+	static const char *contentTypeFromName(const std::string &fname, bool &text);
+};
+
+#endif /* SRC_MAIN_HTTP_CONTENT_H_ */
@@ -62,30 +62,29 @@ json::NamedEnum<IStockApi::FeeScheme> IStockApi::strFeeScheme ({
 	{IStockApi::outcome, "outcome"}
 });
 
-static double awayZero(double v) {
-	if (v < 0) return floor(v);
-	else return ceil(v);
+std::vector<IStockApi::OrderResult> IStockApi::placeOrders(const std::vector<OrderRequest> &orders) {
+	std::vector<OrderResult> res;
+	res.reserve(orders.size());
+	for (auto &&o: orders) {
+		try {
+			res.push_back(OrderResult{
+				placeOrder(o.pair, o.size, o.price, o.clientId, o.replaceId, o.replaceSize),
+				std::string()
+			});
+		} catch (std::exception &e) {
+			res.push_back(OrderResult{json::Value(), e.what()});
+		}
+	}
+	return res;
 }
 
 void IStockApi::MarketInfo::addFees(double &assets, double &price) const {
 	switch (feeScheme) {
-	case IStockApi::currency:
-				   price = price*(1 - sgn(assets)*fees);
-				   break;
-	case IStockApi::assets:
-					assets = assets*(1+fees);
-					break;
-	case IStockApi::income:
-					if (assets>0 ) assets = assets*(1+fees);
-					else price = price*(1+fees);
-					break;
-	case IStockApi::outcome:
-					if (assets<0 ) assets = assets*(1-fees);
-					else price = price*(1-fees);
+	case IStockApi::currency: addFees<IStockApi::currency>(assets, price);break;
+	case IStockApi::assets: addFees<IStockApi::assets>(assets, price);break;
+	case IStockApi::income: addFees<IStockApi::income>(assets, price);break;
+	case IStockApi::outcome: addFees<IStockApi::outcome>(assets, price);break;
 	}
-
-	price = adjValue(price, currency_step, awayZero);
-	assets = adjValue(assets, asset_step, awayZero);
 }
 
 void IStockApi::MarketInfo::removeFees(double &assets, double &price) const {
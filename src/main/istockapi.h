@@ -8,9 +8,13 @@
 #ifndef SRC_MAIN_ISTOCKAPI_H_
 #define SRC_MAIN_ISTOCKAPI_H_
 
+#include <cmath>
 #include <imtjson/value.h>
 #include "../shared/linear_map.h"
 #include <string_view>
+#include <vector>
+
+#include "sgn.h"
 
 #include <imtjson/namedEnum.h>
 
@@ -157,6 +161,26 @@ public:
 		void addFees(double &assets, double &price) const;
 		void removeFees(double &assets, double &price) const;
 
+		///Same as addFees(), but the fee scheme is given as template argument
+		/** Used by code specialized for the fee scheme. The argument must match the feeScheme */
+		template<FeeScheme scheme>
+		void addFees(double &assets, double &price) const {
+			if constexpr(scheme == currency) {
+				price = price*(1 - sgn(assets)*fees);
+			} else if constexpr(scheme == IStockApi::assets) {
+				assets = assets*(1+fees);
+			} else if constexpr(scheme == income) {
+				if (assets>0 ) assets = assets*(1+fees);
+				else price = price*(1+fees);
+			} else {
+				if (assets<0 ) assets = assets*(1-fees);
+				else price = price*(1-fees);
+			}
+			auto awayZero = [](double v) {return v < 0?std::floor(v):std::ceil(v);};
+			price = adjValue(price, currency_step, awayZero);
+			assets = adjValue(assets, asset_step, awayZero);
+		}
+
 		template<typename Fn>
 		double adjValue(double value, double step, Fn &&fn) const {
 			if (step == 0) return value;
@@ -225,6 +249,37 @@ public:
 			json::Value clientId = json::Value(),
 			json::Value replaceId = json::Value(),
 			double replaceSize = 0) = 0;
+
+	///Request to place an order (see placeOrders())
+	struct OrderRequest {
+		std::string pair;
+		double size;
+		double price;
+		json::Value clientId;
+		json::Value replaceId;
+		double replaceSize;
+	};
+
+	///Result of the request to place an order
+	struct OrderResult {
+		///Result of the order - same meaning as the return value of the placeOrder()
+		json::Value id;
+		///Error message, empty if the request was successful
+		std::string error;
+	};
+
+	///Places multiple orders in one request
+	/**
+	 * @param orders orders to place. Each order has the same meaning as arguments of
+	 * the placeOrder()
+	 * @return results of the orders in the same order. The function doesn't throw
+	 * an exception when an order fails, the error is stored in the result
+	 *
+	 * The default implementation calls placeOrder() for every order. Brokers
+	 * which can place the orders concurrently or by single request should override
+	 * this function.
+	 */
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders);
 	///Reset the API
 	/**
 	 * @retval true continue in trading
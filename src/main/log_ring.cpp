@@ -0,0 +1,77 @@
+/*
+ * log_ring.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "log_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::uint64_t LogRing::push(ondra_shared::StrViewA line) {
+	std::uint64_t seq = next.fetch_add(1, std::memory_order_relaxed)+1;
+	Slot &s = slots[seq % capacity];
+	std::uint64_t v = s.version.load(std::memory_order_relaxed);
+	do {
+		//slot is being written by other writer, or it already contains newer line
+		if ((v & 1) || v > 2*seq) {
+			dropCount.fetch_add(1, std::memory_order_relaxed);
+			//mark the line lost, so readers will not wait for it
+			std::uint64_t d = s.dropped.load(std::memory_order_relaxed);
+			while (d < seq && !s.dropped.compare_exchange_weak(d, seq, std::memory_order_release, std::memory_order_relaxed));
+			return seq;
+		}
+	} while (!s.version.compare_exchange_weak(v, 2*seq+1, std::memory_order_relaxed, std::memory_order_relaxed));
+	//the odd version must be visible before any part of the new line
+	std::atomic_thread_fence(std::memory_order_release);
+
+	std::size_t len = std::min<std::size_t>(line.length, maxLineLength);
+	for (std::size_t i = 0, p = 0; p < len; i++, p+=sizeof(std::uint64_t)) {
+		std::uint64_t w = 0;
+		std::memcpy(&w, line.data+p, std::min(sizeof(w), len - p));
+		s.data[i].store(w, std::memory_order_relaxed);
+	}
+	s.length.store(static_cast<std::uint32_t>(len), std::memory_order_relaxed);
+	s.version.store(2*seq+2, std::memory_order_release);
+	return seq;
+}
+
+std::uint64_t LogRing::lastSeq() const {
+	return next.load(std::memory_order_acquire);
+}
+
+LogRing::SlotState LogRing::readSlot(std::uint64_t seq, std::string &out) const {
+	const Slot &s = slots[seq % capacity];
+	std::uint64_t v1 = s.version.load(std::memory_order_acquire);
+	if (v1 < 2*seq+2) {
+		return s.dropped.load(std::memory_order_acquire) >= seq?SlotState::lost:SlotState::pending;
+	}
+	if (v1 > 2*seq+2) return SlotState::lost;
+	std::size_t len = std::min<std::size_t>(s.length.load(std::memory_order_relaxed), maxLineLength);
+	out.resize(len);
+	for (std::size_t i = 0, p = 0; p < len; i++, p+=sizeof(std::uint64_t)) {
+		std::uint64_t w = s.data[i].load(std::memory_order_relaxed);
+		std::memcpy(&out[p], &w, std::min(sizeof(w), len - p));
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	std::uint64_t v2 = s.version.load(std::memory_order_relaxed);
+	return v1 == v2?SlotState::ok:SlotState::lost;
+}
+
+std::vector<LogRing::Line> LogRing::read(std::uint64_t since, std::size_t limit) const {
+	std::vector<Line> out;
+	std::uint64_t last = lastSeq();
+	if (since >= last || limit == 0) return out;
+	std::uint64_t first = since+1;
+	std::uint64_t avail = std::min<std::uint64_t>(capacity, limit);
+	if (last - first + 1 > avail) first = last - avail + 1;
+	out.reserve(last - first + 1);
+	std::string text;
+	for (std::uint64_t seq = first; seq <= last; seq++) {
+		SlotState st = readSlot(seq, text);
+		if (st == SlotState::pending) break;
+		if (st == SlotState::ok) out.push_back(Line{seq, text});
+	}
+	return out;
+}
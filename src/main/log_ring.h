@@ -0,0 +1,90 @@
+/*
+ * log_ring.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_LOG_RING_H_
+#define SRC_MAIN_LOG_RING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../shared/stringview.h"
+
+///Fixed size lock-free ring of log lines
+/**
+ * Every line gets a sequence number (starting by 1). Writers never block - any
+ * thread can write a line. When two writers compete for the same slot (the ring
+ * wrapped during the write), the newer line is dropped and marked as lost.
+ *
+ * Readers read lines incrementally by the sequence number. Every slot is protected by
+ * a seqlock, so a reader detects a line overwritten during the read and skips it.
+ *
+ * Lines longer than maxLineLength are truncated
+ */
+class LogRing {
+public:
+
+	static constexpr std::size_t capacity = 64;
+	static constexpr std::size_t maxLineLength = 504;
+
+	struct Line {
+		std::uint64_t seq;
+		std::string text;
+	};
+
+	///Writes line to the ring - thread safe, lock-free
+	/** @return sequence number assigned to the line */
+	std::uint64_t push(ondra_shared::StrViewA line);
+
+	///Returns sequence number of the last written line (0 = no line yet)
+	std::uint64_t lastSeq() const;
+
+	///Reads lines written after given sequence number
+	/**
+	 * @param since sequence number of the last known line. Use 0 to read
+	 * all lines available in the ring
+	 * @param limit max count of lines (the newest lines are returned)
+	 * @return lines in order of the sequence numbers. Lines which are no longer
+	 * available are skipped. Reading stops at the line which is still being written
+	 */
+	std::vector<Line> read(std::uint64_t since, std::size_t limit = capacity) const;
+
+	///Count of lines dropped due to collision of writers
+	std::uint64_t dropped() const {return dropCount.load(std::memory_order_relaxed);}
+
+protected:
+
+	static constexpr std::size_t words = (maxLineLength+sizeof(std::uint64_t)-1)/sizeof(std::uint64_t);
+
+	struct Slot {
+		///2*seq+1 while the line is written, 2*seq+2 when the line is complete
+		std::atomic<std::uint64_t> version{0};
+		///highest sequence number dropped by a writer for this slot
+		std::atomic<std::uint64_t> dropped{0};
+		std::atomic<std::uint32_t> length{0};
+		std::atomic<std::uint64_t> data[words];
+	};
+
+	Slot slots[capacity];
+	std::atomic<std::uint64_t> next{0};
+	std::atomic<std::uint64_t> dropCount{0};
+
+	enum class SlotState {
+		///line has been read
+		ok,
+		///line has been overwritten by a newer line
+		lost,
+		///line is not complete yet
+		pending
+	};
+
+	SlotState readSlot(std::uint64_t seq, std::string &out) const;
+};
+
+
+
+#endif /* SRC_MAIN_LOG_RING_H_ */
@@ -3,7 +3,16 @@
 #include <shared/stdLogFile.h>
 #include <shared/default_app.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <tuple>
 
 #include "../server/src/simpleServer/abstractStream.h"
 #include "../server/src/simpleServer/address.h"
@@ -11,6 +20,7 @@
 #include "../server/src/simpleServer/http_server.h"
 #include "../shared/linux_crash_handler.h"
 
+#include <imtjson/object.h>
 #include "shared/ini_config.h"
 #include "shared/shared_function.h"
 #include "shared/cmdline.h"
@@ -25,6 +35,14 @@
 #include "ext_stockapi.h"
 #include "stats2report.h"
 #include "backtest.h"
+#include "chart_file.h"
+#include "http_content.h"
+#include "parallel.h"
+#include "stock_recorder.h"
+#include "walk_forward.h"
+#include "montecarlo.h"
+#include "portfolio.h"
+#include "shared_feed.h"
 
 
 using ondra_shared::StdLogFile;
@@ -51,8 +69,8 @@ using StatsSvc = Stats2Report;
 
 class NamedMTrader: public MTrader {
 public:
-	NamedMTrader(IStockSelector &sel, StoragePtr &&storage, PStatSvc statsvc, Config cfg, std::string &&name)
-			:MTrader(sel, std::move(storage), std::move(statsvc), cfg), ident(std::move(name)) {
+	NamedMTrader(IStockSelector &sel, StoragePtr &&storage, PStatSvc statsvc, Config cfg, std::string &&name, StoragePtr &&tier_storage)
+			:MTrader(sel, std::move(storage), std::move(statsvc), cfg, std::move(tier_storage)), ident(std::move(name)) {
 	}
 
 	bool perform() {
@@ -111,6 +129,7 @@ public:
 
 static std::vector<NamedMTrader> traders;
 static StockSelector stockSelector;
+static SharedFeedSelector shadowFeeds(stockSelector);
 
 class ActionQueue: public RefCntObj {
 public:
@@ -163,11 +182,12 @@ void loadTraders(const ondra_shared::IniConfig &ini,
 			if (n[0] == '_') throw std::runtime_error(std::string(n).append(": The trader's name can't begins with underscore '_'"));
 			MTrader::Config mcfg = MTrader::load(ini[n], force_dry_run);
 			logProgress("Started trader $1 (for $2)", n, mcfg.pairsymb);
-			traders.emplace_back(stockSelector, sf.create(n),
+			IStockSelector &ssel = mcfg.shadow?static_cast<IStockSelector &>(shadowFeeds):stockSelector;
+			traders.emplace_back(ssel, sf.create(n),
 					std::make_unique<StatsSvc>([aq](auto &&fn) {
 							aq->push(std::move(fn));
 					}, n, rpt, spread_calc_interval),
-					mcfg, n);
+					mcfg, n, sf.create(std::string(n)+".tiers"));
 		} catch (const std::exception &e) {
 			logFatal("Error: $1", e.what());
 			throw std::runtime_error(std::string("Unable to initialize trader: ").append(n).append(" - ").append(e.what()));
@@ -179,6 +199,7 @@ bool runTraders() {
 	stockSelector.forEachStock([](json::StrViewA, IStockApi&api) {
 		api.reset();
 	});
+	shadowFeeds.newCycle();
 
 	bool hit = false;
 	for (auto &&t : traders) {
@@ -261,7 +282,7 @@ static int eraseTradeHandler(Worker &wrk, simpleServer::ArgList args, simpleServ
 			return StrViewA(tr.ident) == args[0];
 		});
 		if (iter == traders.end()) {
-			stream << "Trader idenitification is invalid: " << args[0] << "\n";
+			stream << "Trader identification is invalid: " << args[0] << "\n";
 			return 2;
 		} else {
 			NamedMTrader  &trader = *iter;
@@ -293,7 +314,7 @@ static int cmd_singlecmd(Worker &wrk, simpleServer::ArgList args, simpleServer::
 		return StrViewA(dr.ident) == trader;
 	});
 	if (iter == traders.end()) {
-		stream << "Trader idenitification is invalid: " << trader << "\n";
+		stream << "Trader identification is invalid: " << trader << "\n";
 		return 1;
 	}
 	try {
@@ -327,7 +348,7 @@ static int cmd_achieve(Worker &wrk, simpleServer::ArgList args, simpleServer::St
 		return StrViewA(dr.ident) == trader;
 	});
 	if (iter == traders.end()) {
-		stream << "Trader idenitification is invalid: " << trader << "\n";
+		stream << "Trader identification is invalid: " << trader << "\n";
 		return 1;
 	}
 	try {
@@ -343,62 +364,668 @@ static int cmd_achieve(Worker &wrk, simpleServer::ArgList args, simpleServer::St
 	}
 }
 
+///Retrieves market info for the backtest - must be called in the trading worker
+static IStockApi::MarketInfo backtestMarketInfo(IStockSelector &stockSel, const BacktestControl::Config &cfg) {
+	IStockApi *broker = stockSel.getStock(cfg.mtrader_cfg.broker);
+	if (broker == nullptr)
+		throw std::runtime_error(std::string("Unknown stock market name: ")+std::string(cfg.mtrader_cfg.broker));
+	return broker->getMarketInfo(cfg.mtrader_cfg.pairsymb);
+}
+
+///Data of the trader needed to start a backtest
+struct TraderSnapshot {
+	MTrader::PSnapshot published;
+	std::vector<IStatSvc::ChartItem> chartCopy;
+	std::unique_ptr<MappedChartFile> chartFile;
+	///chart for the backtest (the copy or the chart file)
+	ondra_shared::StringView<IStatSvc::ChartItem> chart;
+	double spread = 0;
+	double balance = 0;
+	IStockApi::MarketInfo minfo;
+};
+
+///Takes snapshot of the trader for the backtest
+/**
+ * The snapshot published by the trader is used when possible. Otherwise (other
+ * resolution of the chart, or the snapshot was not requested before the last cycle) the
+ * snapshot is taken in the trading worker. The backtest itself runs in the calling thread, so it doesn't
+ * block trading. The chart is not copied, when the backtest uses the chart file
+ */
+static TraderSnapshot snapshotTrader(Worker &wrk, NamedMTrader &t, IStockSelector &stockSel, const BacktestControl::Config &cfg) {
+	TraderSnapshot snap;
+	MTrader::PSnapshot published = t.getSnapshot();
+	if (published != nullptr && cfg.chart_tier <= 1) {
+		//the published chart is immutable, it is not copied
+		snap.published = published;
+		snap.spread = published->spread;
+		snap.balance = published->internal_balance;
+		snap.minfo = published->minfo;
+	} else {
+		run_in_worker(wrk, [&] {
+			t.init();
+			if (cfg.chart_file.empty()) {
+				if (cfg.chart_tier > 1) {
+					snap.chartCopy = t.getChartTier(cfg.chart_tier);
+				} else {
+					auto chart = t.getChart();
+					snap.chartCopy.assign(chart.begin(), chart.end());
+				}
+			}
+			snap.spread = t.getLastSpread();
+			snap.balance = t.getInternalBalance();
+			snap.minfo = backtestMarketInfo(stockSel, cfg);
+			return true;
+		});
+	}
+	if (cfg.chart_file.empty()) {
+		if (snap.published != nullptr) snap.chart = snap.published->chart;
+		else snap.chart = snap.chartCopy;
+	} else {
+		snap.chartFile = std::make_unique<MappedChartFile>(cfg.chart_file);
+		snap.chart = snap.chartFile->getChart();
+	}
+	return snap;
+}
+
+using OptionFn = std::function<bool(StrViewA key, StrViewA value)>;
+
+///Splits arguments key=value of a command
+/**
+ * @param args arguments
+ * @param first index of the first option
+ * @param fn receives trimmed key and value
+ */
+static void forEachOption(simpleServer::ArgList args, std::size_t first, const std::function<void(StrViewA key, StrViewA value)> &fn) {
+	for (std::size_t i = first; i < args.length; i++) {
+		auto arg = args[i];
+		auto splt = arg.split("=",2);
+		StrViewA key = splt();
+		StrViewA value = splt();
+		fn(key.trim(isspace), value.trim(isspace));
+	}
+}
+
+///Trader and options of a backtest command
+struct BacktestArgs {
+	StrViewA ident;
+	NamedMTrader *trader;
+	///options which are not handled by the command, they override the trader's configuration
+	std::vector<ondra_shared::IniItem> options;
+};
+
+///Parses arguments of a backtest command: <trader_ident> [option=value ...]
+/**
+ * @param args arguments
+ * @param fn receives options of the command. It returns true, when the option has been
+ * handled, or false, when the option belongs to the trader's configuration
+ * @exception std::runtime_error trader doesn't exist
+ */
+static BacktestArgs parseBacktestArgs(simpleServer::ArgList args, const OptionFn &fn) {
+	StrViewA ident = args[0];
+	auto iter = std::find_if(traders.begin(), traders.end(), [&](const NamedMTrader &dr){
+		return StrViewA(dr.ident) == ident;
+	});
+	if (iter == traders.end())
+		throw std::runtime_error("Trader identification is invalid: "+std::string(ident));
+	BacktestArgs res{ident, &(*iter), {}};
+	forEachOption(args, 1, [&](StrViewA key, StrViewA value) {
+		if (!fn(key, value)) res.options.emplace_back(ondra_shared::IniItem::data, ident, key, value);
+	});
+	return res;
+}
+
+///Configuration and snapshot of the trader for the backtest
+struct BacktestSetup {
+	BacktestControl::Config cfg;
+	TraderSnapshot snap;
+};
+
+///Loads the configuration of the backtest and takes snapshot of the trader
+static BacktestSetup prepareBacktest(Worker &wrk, IStockSelector &stockSel, const std::string &cfgfname, const BacktestArgs &a) {
+	BacktestSetup res;
+	res.cfg = BacktestControl::loadConfig(cfgfname, a.ident, a.options);
+	res.snap = snapshotTrader(wrk, *a.trader, stockSel, res.cfg);
+	return res;
+}
+
+///Runs backtest without the report, prints summary as JSON
+static int run_headless_backtest(simpleServer::Stream stream, const std::string &ident,
+		const BacktestControl::Config &cfg, const TraderSnapshot &snap, json::Value resume) {
+	auto start = std::chrono::steady_clock::now();
+	BacktestControl bt(snap.minfo, std::make_unique<BacktestStatSvc>(cfg.calc_spread_minutes),
+			cfg, snap.chart, snap.spread, snap.balance);
+	if (resume.defined()) bt.resume(resume);
+	while (bt.step()) {}
+	auto res = bt.getResult();
+	double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+
+	json::Value summary = json::Object
+			("trader", ident)
+			("profit", res.profit)
+			("trades", res.trades)
+			("drawdown", res.drawdown)
+			("steps", bt.getSteps())
+			("runtime_ms", runtime);
+	stream << summary.stringify().str() << "\n";
+	return 0;
+}
+
 static int cmd_backtest(Worker &wrk, simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname, IStockSelector &stockSel, Report &rpt) {
 	if (args.length < 1) {
 		stream << "Need arguments: <trader_ident> [option=value ...]\n"; return 1;
 	}
-	StrViewA trader = args[0];
-	auto iter = std::find_if(traders.begin(), traders.end(), [&](const NamedMTrader &dr){
-		return StrViewA(dr.ident) == trader;
-	});
-	if (iter == traders.end()) {
-		stream << "Trader idenitification is invalid: " << trader << "\n";
-		return 1;
+	try {
+		bool headless = false;
+		json::Value resume;
+		BacktestArgs a = parseBacktestArgs(args, [&](StrViewA key, StrViewA value) {
+			if (key == "headless") {
+				headless = value == "1" || value == "true" || value == "yes";
+			} else if (key == "resume") {
+				resume = BacktestControl::loadCheckpoint(std::string(value));
+				if (!resume.defined()) throw std::runtime_error("Can't load the checkpoint: "+std::string(value));
+			} else {
+				return false;
+			}
+			return true;
+		});
+
+		auto [cfg, snap] = prepareBacktest(wrk, stockSel, cfgfname, a);
+		if (headless) {
+			return run_headless_backtest(stream, a.trader->ident, cfg, snap, resume);
+		}
+
+		//the report is owned by the trading worker, the results are passed there periodically
+		auto svc = std::make_unique<BacktestReportSvc>(cfg.calc_spread_minutes);
+		BacktestReportSvc &results = *svc;
+		Stats2Report target([](CalcSpreadFn &&fn) {fn();}, "backtest", rpt, 0);
+		auto publish = [&] {
+			run_in_worker(wrk, [&] {
+				results.flush(target);
+				rpt.genReport();
+				return true;
+			});
+		};
+
+		BacktestControl backtest(snap.minfo, std::move(svc), cfg, snap.chart, snap.spread, snap.balance);
+		if (resume.defined()) backtest.resume(resume);
+		auto tc = std::chrono::system_clock::now();
+		int mdv = 0;
+		while (backtest.step()) {
+			auto tn = std::chrono::system_clock::now();
+			if (std::chrono::duration_cast<std::chrono::seconds>(tn-tc).count()>15) {
+				publish();
+				tc = tn;
+			}
+			mdv++;
+			if (mdv >= 60) {
+				stream('.');
+				if (!stream.flush()) {
+					//the progress can be resumed later
+					backtest.saveCheckpoint();
+					break;
+				}
+				mdv = 0;
+			}
+		}
+		publish();
+		stream << "OK\n";
+		return 0;
+	} catch (std::exception &e) {
+		stream << e.what() << "\n";
+		return 2;
 	}
 
-	NamedMTrader &t = *iter;
-	try {
+}
+
+///Parses values of the swept option
+/**
+ * @param value list of values separated by comma (v1,v2,v3) or numeric range (from:to:step)
+ * or single value
+ * @return list of values
+ */
+static std::vector<std::string> parseSweepValues(const std::string &value) {
+	std::vector<std::string> res;
+	if (value.find(',') != value.npos) {
+		std::size_t p = 0;
+		while (p <= value.length()) {
+			std::size_t n = value.find(',', p);
+			if (n == value.npos) n = value.length();
+			StrViewA v = StrViewA(value).substr(p, n-p).trim(isspace);
+			if (!v.empty()) res.push_back(std::string(v));
+			p = n+1;
+		}
+	} else if (value.find(':') != value.npos) {
+		double from, to, step;
+		char c1, c2;
+		std::istringstream in(value);
+		if (!(in >> from >> c1 >> to >> c2 >> step) || c1 != ':' || c2 != ':' || step <= 0 || to < from)
+			throw std::runtime_error("Invalid range (from:to:step): "+value);
+		std::size_t cnt = static_cast<std::size_t>(std::floor((to-from)/step+1e-9))+1;
+		for (std::size_t i = 0; i < cnt; i++) {
+			std::ostringstream buff;
+			buff << std::setprecision(10) << (from + i*step);
+			res.push_back(buff.str());
+		}
+	} else {
+		res.push_back(value);
+	}
+	return res;
+}
+
+struct SweepParam {
+	std::string key;
+	std::vector<std::string> values;
+};
+
+///Creates configurations for all combinations of swept options
+/**
+ * @param cfgfname configuration file
+ * @param trader trader's section
+ * @param params swept options
+ * @return list of configurations. The first option changes slowest
+ */
+static std::vector<WalkForward::Candidate> expandSweep(const std::string &cfgfname, StrViewA trader, const std::vector<SweepParam> &params) {
+	std::size_t total = 1;
+	for (auto &&p: params) {
+		total *= p.values.size();
+		if (total > 100000) throw std::runtime_error("Too many combinations");
+	}
+
+	std::vector<WalkForward::Candidate> res;
+	res.reserve(total);
+	for (std::size_t r = 0; r < total; r++) {
 		std::vector<ondra_shared::IniItem> options;
-		for (std::size_t i = 1; i < args.length; i++) {
-			auto arg = args[i];
-			auto splt = arg.split("=",2);
-			StrViewA key = splt();
-			StrViewA value = splt();
-			key = key.trim(isspace);
-			value = value.trim(isspace);
-			options.emplace_back(ondra_shared::IniItem::data, trader, key, value);
+		std::string desc;
+		std::size_t run = r;
+		for (auto iter = params.rbegin(); iter != params.rend(); ++iter) {
+			const std::string &value = iter->values[run % iter->values.size()];
+			options.emplace_back(ondra_shared::IniItem::data, trader, StrViewA(iter->key), StrViewA(value));
+			desc = iter->key + "=" + value + (desc.empty()?"":" ") + desc;
+			run /= iter->values.size();
 		}
+		res.push_back(WalkForward::Candidate{desc, BacktestControl::loadConfig(cfgfname, trader, options)});
+	}
+	return res;
+}
 
-		auto cfg = BacktestControl::loadConfig(cfgfname, trader, options);
+static int cmd_backtest_sweep(Worker &wrk, simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname, IStockSelector &stockSel) {
+	if (args.length < 2) {
+		stream << "Need arguments: <trader_ident> <option=v1,v2,...|option=from:to:step> ... [threads=N]\n"; return 1;
+	}
+	try {
+		std::vector<SweepParam> params;
+		unsigned int threads = 0;
+		BacktestArgs a = parseBacktestArgs(args, [&](StrViewA key, StrViewA value) {
+			if (key == "threads") {
+				threads = std::strtoul(std::string(value).c_str(), nullptr, 10);
+			} else {
+				params.push_back(SweepParam{std::string(key), parseSweepValues(std::string(value))});
+				if (params.back().values.empty())
+					throw std::runtime_error("No values for option: "+std::string(key));
+			}
+			return true;
+		});
 
-		run_in_worker(wrk, [&] {
-			t.init();
-			int mdv = 0;
-			BacktestControl backtest(stockSel, rpt, cfg, t.getChart(), t.getLastSpread(), t.getInternalBalance());
-			auto tc = std::chrono::system_clock::now();
-			while (backtest.step()) {
-				auto tn = std::chrono::system_clock::now();
-				if (std::chrono::duration_cast<std::chrono::seconds>(tn-tc).count()>15) {
-					rpt.genReport();
-					tc = tn;
-				}
-				mdv++;
-				if (mdv >= 60) {
-					stream('.');
-					if (!stream.flush()) break;
- 					mdv = 0;
-				}
+		std::vector<WalkForward::Candidate> cfgs = expandSweep(cfgfname, a.ident, params);
+		std::size_t total = cfgs.size();
+
+		//all runs share one read-only chart, every run converts it to columns by chunks,
+		//so the chart (which can be memory mapped) is never copied whole
+		TraderSnapshot snap = snapshotTrader(wrk, *a.trader, stockSel, cfgs[0].cfg);
+		ondra_shared::StringView<IStatSvc::ChartItem> chart = snap.chart;
+		double spread = snap.spread, balance = snap.balance;
+		const IStockApi::MarketInfo &minfo = snap.minfo;
+
+		struct RunResult {
+			std::size_t run;
+			BacktestControl::Result result;
+			double runtime;
+		};
+
+		std::vector<RunResult> results;
+		results.reserve(total);
+		std::mutex lock;
+		std::atomic<bool> stop(false);
+		stream << "Running " << std::to_string(total) << " backtests\n";
+		stream.flush();
+
+		parallel_for(total, threads, [&](std::size_t r, unsigned int) {
+			if (stop) return;
+			auto start = std::chrono::steady_clock::now();
+			BacktestControl bt(minfo, std::make_unique<BacktestStatSvc>(cfgs[r].cfg.calc_spread_minutes),
+					cfgs[r].cfg, chart, spread, balance);
+			while (!stop && bt.step()) {}
+			RunResult res{r, bt.getResult(),
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count()};
+
+			std::ostringstream buff;
+			buff << cfgs[r].desc << "\tprofit=" << res.result.profit
+					<< "\ttrades=" << res.result.trades
+					<< "\tdrawdown=" << res.result.drawdown
+					<< "\ttime=" << res.runtime << "ms\n";
+			std::lock_guard<std::mutex> _(lock);
+			results.push_back(res);
+			stream << buff.str();
+			if (!stream.flush()) stop = true;
+		});
+		if (stop) return 2;
+
+		std::sort(results.begin(), results.end(), [](const RunResult &a, const RunResult &b) {
+			return a.result.profit > b.result.profit;
+		});
+		std::ostringstream buff;
+		buff << "\nRank\tProfit\tTrades\tDrawdown\tTime(ms)\tOptions\n";
+		std::size_t rank = 1;
+		for (auto &&r: results) {
+			buff << rank++ << "\t" << r.result.profit
+					<< "\t" << r.result.trades
+					<< "\t" << r.result.drawdown
+					<< "\t" << r.runtime
+					<< "\t" << cfgs[r.run].desc << "\n";
+		}
+		stream << buff.str();
+		stream << "OK\n";
+		return 0;
+	} catch (std::exception &e) {
+		stream << e.what() << "\n";
+		return 2;
+	}
+}
+
+static int cmd_backtest_walkforward(Worker &wrk, simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname, IStockSelector &stockSel) {
+	if (args.length < 3) {
+		stream << "Need arguments: <trader_ident> train=<days> test=<days> [option=v1,v2,...|option=from:to:step] ... [threads=N]\n"; return 1;
+	}
+	try {
+		std::vector<SweepParam> params;
+		unsigned int threads = 0;
+		double train_days = 0, test_days = 0;
+		BacktestArgs a = parseBacktestArgs(args, [&](StrViewA key, StrViewA value) {
+			if (key == "threads") {
+				threads = std::strtoul(std::string(value).c_str(), nullptr, 10);
+			} else if (key == "train") {
+				train_days = std::strtod(std::string(value).c_str(), nullptr);
+			} else if (key == "test") {
+				test_days = std::strtod(std::string(value).c_str(), nullptr);
+			} else {
+				params.push_back(SweepParam{std::string(key), parseSweepValues(std::string(value))});
+				if (params.back().values.empty())
+					throw std::runtime_error("No values for option: "+std::string(key));
 			}
 			return true;
 		});
-		rpt.genReport();
+		if (train_days <= 0 || test_days <= 0)
+			throw std::runtime_error("Both 'train' and 'test' must be specified (in days)");
+		if (params.empty()) {
+			params.push_back(SweepParam{"buy_step_mult", parseSweepValues("0.5:2:0.25")});
+			params.push_back(SweepParam{"sell_step_mult", parseSweepValues("0.5:2:0.25")});
+		}
+
+		std::vector<WalkForward::Candidate> cfgs = expandSweep(cfgfname, a.ident, params);
+		TraderSnapshot snap = snapshotTrader(wrk, *a.trader, stockSel, cfgs[0].cfg);
+
+		WalkForward wf(snap.chart, snap.minfo, std::move(cfgs), snap.balance);
+		auto windows = wf.split(static_cast<std::uint64_t>(train_days*86400000.0),
+				static_cast<std::uint64_t>(test_days*86400000.0));
+		if (windows.empty()) throw std::runtime_error("The chart is too short for the specified windows");
+
+		stream << "Running " << std::to_string(windows.size()) << " windows\n";
+		stream.flush();
+
+		auto start = std::chrono::steady_clock::now();
+		auto results = wf.run(windows, threads, [&](const WalkForward::WindowResult &r) {
+			std::ostringstream buff;
+			buff << "Window " << wf.getTime(r.window.train_end)
+					<< "\tspread=" << r.spread
+					<< "\ttrain=" << r.train.profit
+					<< "\ttest=" << r.test.profit
+					<< "\ttrades=" << r.test.trades
+					<< "\t" << wf.getCandidate(r.best).desc << "\n";
+			stream << buff.str();
+			stream.flush();
+		});
+		double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+
+		std::ostringstream buff;
+		buff << "\nTest from\tTest to\tSpread\tTrain profit\tTest profit\tTrades\tDrawdown\tOptions\n";
+		for (auto &&r: results) {
+			buff << wf.getTime(r.window.train_end)
+					<< "\t" << wf.getTime(r.window.test_end-1)
+					<< "\t" << r.spread
+					<< "\t" << r.train.profit
+					<< "\t" << r.test.profit
+					<< "\t" << r.test.trades
+					<< "\t" << r.test.drawdown
+					<< "\t" << wf.getCandidate(r.best).desc << "\n";
+		}
+		stream << buff.str();
+
+		auto sum = wf.summarize(results);
+		json::Value summary = json::Object
+				("trader", a.trader->ident)
+				("windows", results.size())
+				("train_profit", sum.train_profit)
+				("test_profit", sum.test_profit)
+				("test_trades", sum.test_trades)
+				("test_drawdown", sum.test_drawdown)
+				("efficiency", sum.efficiency)
+				("runtime_ms", runtime);
+		stream << summary.stringify().str() << "\n";
 		stream << "OK\n";
 		return 0;
 	} catch (std::exception &e) {
 		stream << e.what() << "\n";
 		return 2;
 	}
+}
 
+static int cmd_backtest_montecarlo(Worker &wrk, simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname, IStockSelector &stockSel) {
+	if (args.length < 1) {
+		stream << "Need arguments: <trader_ident> [paths=N] [model=bootstrap|gbm|jump] [block=N] [jump_prob=P] [jump_size=S] [seed=N] [threads=N] [option=value ...]\n"; return 1;
+	}
+	try {
+		MonteCarlo::Options opts;
+		BacktestArgs a = parseBacktestArgs(args, [&](StrViewA key, StrViewA value) {
+			std::string v(value);
+			if (key == "paths") opts.paths = std::strtoul(v.c_str(), nullptr, 10);
+			else if (key == "model") opts.model = strMonteCarloModel[value];
+			else if (key == "block") opts.block = std::strtoul(v.c_str(), nullptr, 10);
+			else if (key == "jump_prob") opts.jump_prob = std::strtod(v.c_str(), nullptr);
+			else if (key == "jump_size") opts.jump_size = std::strtod(v.c_str(), nullptr);
+			else if (key == "seed") opts.seed = std::strtoull(v.c_str(), nullptr, 10);
+			else if (key == "threads") opts.threads = std::strtoul(v.c_str(), nullptr, 10);
+			else return false;
+			return true;
+		});
+		if (opts.paths == 0 || opts.paths > 1000000) throw std::runtime_error("'paths' must be between 1 and 1000000");
+
+		auto [cfg, snap] = prepareBacktest(wrk, stockSel, cfgfname, a);
+
+		MonteCarlo mc(snap.chart, snap.minfo, cfg, snap.spread, snap.balance);
+		std::size_t report_step = std::max<std::size_t>(1, opts.paths/20);
+		stream << "Running " << std::to_string(opts.paths) << " paths\n";
+		stream.flush();
+
+		auto start = std::chrono::steady_clock::now();
+		auto results = mc.run(opts, [&](std::size_t done) {
+			if (done % report_step) return true;
+			stream << std::to_string(done) << "/" << std::to_string(opts.paths) << "\n";
+			return stream.flush();
+		});
+		if (results.size() != opts.paths) return 2;
+		double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+
+		json::Object summary(MonteCarlo::summarize(results));
+		summary("trader", a.trader->ident)
+				("model", strMonteCarloModel[opts.model])
+				("runtime_ms", runtime);
+		stream << json::Value(summary).stringify().str() << "\n";
+		stream << "OK\n";
+		return 0;
+	} catch (std::exception &e) {
+		stream << e.what() << "\n";
+		return 2;
+	}
+}
+
+static int cmd_backtest_portfolio(Worker &wrk, simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname, IStockSelector &stockSel) {
+	try {
+		struct Option {
+			std::string trader;
+			std::string key;
+			std::string value;
+		};
+		std::vector<Option> options;
+		unsigned int threads = 0;
+		std::uint64_t resolution = 60;
+		std::string output;
+		forEachOption(args, 0, [&](StrViewA key, StrViewA value) {
+			if (key == "threads") {
+				threads = std::strtoul(std::string(value).c_str(), nullptr, 10);
+			} else if (key == "resolution") {
+				resolution = std::strtoull(std::string(value).c_str(), nullptr, 10);
+			} else if (key == "output") {
+				output = std::string(value);
+			} else {
+				//trader/option applies to the single trader
+				std::string k(key);
+				auto p = k.find('/');
+				if (p == k.npos) options.push_back(Option{std::string(), k, std::string(value)});
+				else options.push_back(Option{k.substr(0,p), k.substr(p+1), std::string(value)});
+			}
+		});
+		if (traders.empty()) throw std::runtime_error("No traders");
+
+		std::vector<PortfolioBacktest::Member> members;
+		for (auto &&t: traders) {
+			std::vector<ondra_shared::IniItem> items;
+			for (auto &&o: options) {
+				if (o.trader.empty() || o.trader == t.ident)
+					items.emplace_back(ondra_shared::IniItem::data, StrViewA(t.ident), StrViewA(o.key), StrViewA(o.value));
+			}
+			members.push_back(PortfolioBacktest::Member{t.ident, {},
+				BacktestControl::loadConfig(cfgfname, t.ident, items), {}, 0, 0});
+		}
+
+		//every snapshot is taken in a separate job, so trading can continue between them
+		std::vector<TraderSnapshot> snaps;
+		snaps.reserve(members.size());
+		for (std::size_t i = 0; i < members.size(); i++) {
+			auto &m = members[i];
+			snaps.push_back(snapshotTrader(wrk, traders[i], stockSel, m.cfg));
+			m.chart = snaps.back().chart;
+			m.spread = snaps.back().spread;
+			m.balance = snaps.back().balance;
+			m.minfo = snaps.back().minfo;
+		}
+
+		PortfolioBacktest pb(std::move(members), resolution*60000);
+		stream << "Running " << std::to_string(pb.size()) << " traders\n";
+		stream.flush();
+
+		auto start = std::chrono::steady_clock::now();
+		pb.run(threads, [&](std::size_t idx, const PortfolioBacktest::MemberResult &r) {
+			std::ostringstream buff;
+			buff << pb.getMember(idx).name
+					<< "\tprofit=" << r.result.profit
+					<< "\ttrades=" << r.result.trades
+					<< "\tdrawdown=" << r.result.drawdown
+					<< "\tmax_exposure=" << r.max_exposure << "\n";
+			stream << buff.str();
+			stream.flush();
+		});
+		auto curve = pb.merge();
+		double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+
+		if (!output.empty()) {
+			std::ofstream out(output, std::ios::out|std::ios::trunc);
+			if (!out) throw std::runtime_error("Can't create the file: "+output);
+			out << "time,equity,exposure\n";
+			for (auto &&s: curve) out << s.time << "," << s.equity << "," << s.exposure << "\n";
+		}
+
+		auto sum = PortfolioBacktest::summarize(curve);
+		json::Value summary = json::Object
+				("traders", pb.size())
+				("profit", sum.profit)
+				("drawdown", sum.drawdown)
+				("max_exposure", sum.max_exposure)
+				("points", curve.size())
+				("runtime_ms", runtime);
+		stream << summary.stringify().str() << "\n";
+		stream << "OK\n";
+		return 0;
+	} catch (std::exception &e) {
+		stream << e.what() << "\n";
+		return 2;
+	}
+}
+
+///Replays recorded communication of the trader with the broker
+/**
+ * The trader is created from the current configuration, it starts from the recorded
+ * state and it is connected to the ReplayStockApi. Nothing is sent to the broker and
+ * the state of the live trader is not changed
+ */
+static int cmd_replay(simpleServer::ArgList args, simpleServer::Stream stream, const std::string &cfgfname) {
+	if (args.length < 2) {
+		stream << "Need arguments: <trader_ident> <record_file>\n"; return 1;
+	}
+	std::string trader ( args[0] );
+	std::string fname ( args[1] );
+	try {
+		ondra_shared::IniConfig ini;
+		ini.load(cfgfname);
+		MTrader::Config mcfg = MTrader::load(ini[trader], false);
+		mcfg.dry_run = false;
+		mcfg.record_file.clear();
+
+		ReplayStockApi replay(fname);
+
+		class ReplayStockSelector: public IStockSelector {
+		public:
+			ReplayStockSelector(IStockApi &api):api(api) {}
+			virtual IStockApi *getStock(const std::string_view &) const override {
+				return &api;
+			}
+			virtual void forEachStock(EnumFn fn) const override {
+				fn("replay", api);
+			}
+		protected:
+			IStockApi &api;
+		};
+
+		ReplayStockSelector sel(replay);
+		//same hash as live trader, so the trader recognizes its own orders
+		std::hash<std::string> h;
+		MTrader t(sel, std::make_unique<MemStorage>(replay.getState()),
+				std::make_unique<BacktestStatSvc>(0, h(trader)), mcfg);
+
+		auto start = std::chrono::steady_clock::now();
+		std::size_t cycles = 0, errors = 0;
+		while (replay.nextCycle()) {
+			cycles++;
+			try {
+				t.perform();
+			} catch (IStockApi::Exception &e) {
+				//recorded error of the broker
+				stream << "Cycle " << std::to_string(cycles) << ": " << e.what() << "\n";
+				errors++;
+			}
+		}
+		double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+		json::Value summary = json::Object
+				("trader", trader)
+				("cycles", cycles)
+				("errors", errors)
+				("runtime_ms", runtime);
+		stream << summary.stringify().str() << "\n";
+		stream << "OK\n";
+		return 0;
+	} catch (std::exception &e) {
+		stream << e.what() << "\n";
+		return 2;
+	}
 }
 
 static ondra_shared::CrashHandler report_crash([](const char *line) {
@@ -430,7 +1057,12 @@ public:
 				"erase_trade  - erases trade. Need id of trader and id of trade",
 				"reset        - erases all trades expect the last one",
 				"achieve      - achieve an internal state (achieve mode)",
-				"repair       - repair pair"
+				"repair       - repair pair",
+				"backtest_sweep - run backtests for all combinations of options in parallel",
+				"backtest_walkforward - walk-forward optimization with out-of-sample report",
+				"backtest_montecarlo - run backtests on synthetic price paths",
+				"backtest_portfolio - run backtests of all traders in parallel, combined result",
+				"replay       - replay recorded communication with the broker (see record_file)"
 		};
 
 		const char *intro[] = {
@@ -517,23 +1149,33 @@ int main(int argc, char **argv) {
 						stockSelector.loadStockMarkets(app.config["brokers"], test);
 
 						auto web_bind = rptsect["http_bind"];
+						auto httpThreads = rptsect["http_threads"].getUInt(2);
+						//files can be turned off, when the report is served by the internal server only
+						auto writeFiles = rptsect["write_files"].getBool(true);
+
+
+						StorageFactory sf(storagePath,5,storageBinary?Storage::binjson:Storage::json);
+						StorageFactory rptf(rptpath,2,Storage::json);
+						StorageFactory deltaf(rptpath,1,Storage::json);
+
+						Report rpt(writeFiles?rptf.create("report.json"):nullptr,
+								   writeFiles?deltaf.create("report_delta.json"):nullptr,
+								   rptinterval, a2np);
+						if (rptsect["shards"].getBool(false)) {
+							rpt.enableShards(writeFiles?std::optional<StorageFactory>(StorageFactory(rptpath,1,Storage::json)):std::nullopt);
+						}
 
 						std::unique_ptr<simpleServer::MiniHttpServer> srv;
 
 						if (web_bind.defined()) {
+							rpt.enablePublish(true);
 							simpleServer::NetAddr addr = simpleServer::NetAddr::create(web_bind.getString(),11223);
-							srv = std::make_unique<simpleServer::MiniHttpServer>(addr, 1, 1);
+							srv = std::make_unique<simpleServer::MiniHttpServer>(addr, httpThreads, 1);
 							(*srv)  >>= AuthMapper(rptsect["http_auth"].getString(),name)
-									>>= simpleServer::HttpFileMapper(std::string(rptpath), "index.html");
+									>>= ReportHttpHandler(rpt, CachedFileMapper(std::string(rptpath), "index.html"));
 						}
 
 
-						StorageFactory sf(storagePath,5,storageBinary?Storage::binjson:Storage::json);
-						StorageFactory rptf(rptpath,2,Storage::json);
-
-						Report rpt(rptf.create("report.json"), rptinterval, a2np);
-
-
 
 						Scheduler sch = ondra_shared::Scheduler::create();
 						Worker wrk = schedulerGetWorker(sch);
@@ -544,36 +1186,34 @@ int main(int argc, char **argv) {
 						logNote("---- Starting service ----");
 
 						cntr.addCommand("calc_range",[&](const simpleServer::ArgList &args, simpleServer::Stream out){
-
-							ondra_shared::Countdown cnt(1);
-							wrk >> [&] {
+							for(auto &&t:traders) {
 								try {
-									for(auto &&t:traders) {							;
-										std::ostringstream buff;
-										auto result = t.calc_min_max_range();
-										auto ass = t.getMarketInfo().asset_symbol;
-										auto curs = t.getMarketInfo().currency_symbol;
-										buff << "Trader " << t.getConfig().title
-												<< ":" << std::endl
-												<< "\tAssets:\t\t\t" << result.assets << " " << ass << std::endl
-												<< "\tAssets value:\t\t" << result.value << " " << curs << std::endl
-												<< "\tAvailable assets:\t" << result.avail_assets << " " << ass << std::endl
-												<< "\tAvailable money:\t" << result.avail_money << " " << curs << std::endl
-												<< "\tMin price:\t\t" << result.min_price << " " << curs << std::endl;
-										if (result.min_price == 0)
-										   buff << "\t - money left:\t\t" << (result.avail_money-result.value) << " " << curs << std::endl;
-										buff << "\tMax price:\t\t" << result.max_price << " " << curs << std::endl;
-										out << buff.str();
-										out.flush();
-
-									}
+									const MTrader_Config &cfg = t.getConfig();
+									//only the broker calls run in the worker, the brokers are not thread safe
+									auto [minfo, avail_assets, avail_money, price] = run_in_worker(wrk, [&]{
+										auto [assets, money] = t.getBalances();
+										return std::make_tuple(t.getMarketInfo(), assets, money, t.getCurPrice());
+									});
+									auto result = MTrader::calc_min_max_range(cfg, avail_assets, avail_money, price);
+									const auto &ass = minfo.asset_symbol;
+									const auto &curs = minfo.currency_symbol;
+									std::ostringstream buff;
+									buff << "Trader " << cfg.title
+											<< ":" << std::endl
+											<< "\tAssets:\t\t\t" << result.assets << " " << ass << std::endl
+											<< "\tAssets value:\t\t" << result.value << " " << curs << std::endl
+											<< "\tAvailable assets:\t" << result.avail_assets << " " << ass << std::endl
+											<< "\tAvailable money:\t" << result.avail_money << " " << curs << std::endl
+											<< "\tMin price:\t\t" << result.min_price << " " << curs << std::endl;
+									if (result.min_price == 0)
+									   buff << "\t - money left:\t\t" << (result.avail_money-result.value) << " " << curs << std::endl;
+									buff << "\tMax price:\t\t" << result.max_price << " " << curs << std::endl;
+									out << buff.str();
+									out.flush();
 								} catch (std::exception &e) {
-									out << e.what();
+									out << e.what() << "\n";
 								}
-								cnt.dec();
-							};
-							cnt.wait();
-
+							}
 							return 0;
 						});
 
@@ -616,6 +1256,21 @@ int main(int argc, char **argv) {
 						cntr.addCommand("backtest", [&](simpleServer::ArgList args, simpleServer::Stream stream){
 							return cmd_backtest(wrk, args, stream, app.configPath.string(), stockSelector, rpt);
 						});
+						cntr.addCommand("backtest_sweep", [&](simpleServer::ArgList args, simpleServer::Stream stream){
+							return cmd_backtest_sweep(wrk, args, stream, app.configPath.string(), stockSelector);
+						});
+						cntr.addCommand("backtest_walkforward", [&](simpleServer::ArgList args, simpleServer::Stream stream){
+							return cmd_backtest_walkforward(wrk, args, stream, app.configPath.string(), stockSelector);
+						});
+						cntr.addCommand("backtest_montecarlo", [&](simpleServer::ArgList args, simpleServer::Stream stream){
+							return cmd_backtest_montecarlo(wrk, args, stream, app.configPath.string(), stockSelector);
+						});
+						cntr.addCommand("backtest_portfolio", [&](simpleServer::ArgList args, simpleServer::Stream stream){
+							return cmd_backtest_portfolio(wrk, args, stream, app.configPath.string(), stockSelector);
+						});
+						cntr.addCommand("replay", [&](simpleServer::ArgList args, simpleServer::Stream stream){
+							return cmd_replay(args, stream, app.configPath.string());
+						});
 						std::size_t id = 0;
 						cntr.addCommand("run",[&](simpleServer::ArgList, simpleServer::Stream) {
 
@@ -651,7 +1306,9 @@ int main(int argc, char **argv) {
 
 						sch.remove(id);
 						sch.sync();
+						rpt.closeStreams();
 						traders.clear();
+						shadowFeeds.clear();
 						stockSelector.clear();
 
 					}
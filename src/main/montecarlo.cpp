@@ -0,0 +1,176 @@
+/*
+ * montecarlo.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "montecarlo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include <imtjson/object.h>
+#include "parallel.h"
+
+json::NamedEnum<MonteCarlo::Model> strMonteCarloModel({
+	{MonteCarlo::Model::bootstrap, "bootstrap"},
+	{MonteCarlo::Model::gbm, "gbm"},
+	{MonteCarlo::Model::jump, "jump"}
+});
+
+MonteCarlo::MonteCarlo(ondra_shared::StringView<ChartItem> chart,
+		const IStockApi::MarketInfo &minfo,
+		const BacktestControl::Config &cfg,
+		double spread,
+		double balance)
+	:chart(chart),minfo(minfo),cfg(cfg),spread(spread),balance(balance) {
+	if (chart.length < 2) throw std::runtime_error("Monte Carlo: the chart is too short");
+
+	returns.reserve(chart.length-1);
+	double sum_hs = 0;
+	double prev = 0;
+	for (std::size_t i = 0; i < chart.length; i++) {
+		const ChartItem &itm = chart[i];
+		double lm = std::log(itm.ask*itm.bid)*0.5;
+		if (i) returns.push_back(lm - prev);
+		else first_price = std::exp(lm);
+		prev = lm;
+		sum_hs += std::log(itm.ask/itm.bid)*0.5;
+	}
+	half_spread = sum_hs/chart.length;
+
+	double sum = 0, sum2 = 0;
+	for (double r: returns) {
+		sum += r;
+		sum2 += r*r;
+	}
+	drift = sum/returns.size();
+	volatility = std::sqrt(std::max(0.0, sum2/returns.size() - drift*drift));
+}
+
+void MonteCarlo::generate(std::size_t idx, const Options &opts, ChartSoA &out) const {
+	std::seed_seq seed{static_cast<std::uint32_t>(opts.seed), static_cast<std::uint32_t>(opts.seed>>32),
+		static_cast<std::uint32_t>(idx), static_cast<std::uint32_t>(static_cast<std::uint64_t>(idx)>>32)};
+	std::mt19937_64 rnd(seed);
+	std::normal_distribution<double> norm;
+	std::uniform_real_distribution<double> uni;
+
+	double hs = std::exp(half_spread);
+	double lp = std::log(first_price);
+	auto push = [&](std::size_t i) {
+		double p = std::exp(lp);
+		out.push_back(ChartItem{chart[i].time, p*hs, p/hs, p});
+	};
+
+	out.clear();
+	push(0);
+	std::size_t cnt = returns.size();
+	switch (opts.model) {
+	case Model::bootstrap: {
+		std::size_t block = std::max<std::size_t>(1, std::min(opts.block, cnt));
+		std::uniform_int_distribution<std::size_t> start(0, cnt - block);
+		std::size_t i = 0;
+		while (i < cnt) {
+			std::size_t b = start(rnd);
+			for (std::size_t j = 0; j < block && i < cnt; j++) {
+				lp += returns[b+j];
+				push(++i);
+			}
+		}
+	} break;
+	case Model::gbm:
+		for (std::size_t i = 0; i < cnt;) {
+			lp += drift + volatility * norm(rnd);
+			push(++i);
+		}
+		break;
+	case Model::jump: {
+		double jsize = opts.jump_size > 0?opts.jump_size:volatility*10;
+		for (std::size_t i = 0; i < cnt;) {
+			lp += drift + volatility * norm(rnd);
+			if (uni(rnd) < opts.jump_prob) lp += jsize * norm(rnd);
+			push(++i);
+		}
+	} break;
+	}
+}
+
+std::vector<MonteCarlo::PathResult> MonteCarlo::run(const Options &opts, ProgressFn progress) const {
+	unsigned int threads = opts.threads?opts.threads:defaultThreadCount();
+	std::vector<ChartSoA> buffers(threads);
+	std::vector<PathResult> results(opts.paths);
+	std::vector<bool> finished(opts.paths, false);
+	std::atomic<bool> stop(false);
+	std::mutex lock;
+	std::size_t done = 0;
+
+	parallel_for(opts.paths, threads, [&](std::size_t idx, unsigned int thrid) {
+		if (stop) return;
+		ChartSoA &buff = buffers[thrid];
+		generate(idx, opts, buff);
+		BacktestControl bt(minfo, std::make_unique<BacktestStatSvc>(cfg.calc_spread_minutes),
+				cfg, buff.view(), spread, balance);
+		while (!stop && bt.step()) {}
+		auto r = bt.getResult();
+		std::lock_guard<std::mutex> _(lock);
+		if (stop) return;
+		results[idx] = PathResult{r.profit, r.drawdown, r.trades};
+		finished[idx] = true;
+		++done;
+		if (progress && !progress(done)) stop = true;
+	});
+	if (stop) {
+		std::size_t j = 0;
+		for (std::size_t i = 0; i < results.size(); i++) {
+			if (finished[i]) results[j++] = results[i];
+		}
+		results.resize(j);
+	}
+	return results;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+	if (sorted.empty()) return 0;
+	double pos = p * (sorted.size()-1);
+	std::size_t i = static_cast<std::size_t>(pos);
+	if (i+1 >= sorted.size()) return sorted.back();
+	double f = pos - i;
+	return sorted[i]*(1-f) + sorted[i+1]*f;
+}
+
+static json::Value distribution(std::vector<double> &&values) {
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for (double v: values) sum += v;
+	return json::Object
+			("mean", values.empty()?0:sum/values.size())
+			("p1", percentile(values, 0.01))
+			("p5", percentile(values, 0.05))
+			("p25", percentile(values, 0.25))
+			("p50", percentile(values, 0.5))
+			("p75", percentile(values, 0.75))
+			("p95", percentile(values, 0.95))
+			("p99", percentile(values, 0.99));
+}
+
+json::Value MonteCarlo::summarize(const std::vector<PathResult> &results) {
+	std::vector<double> profit, drawdown, trades;
+	profit.reserve(results.size());
+	drawdown.reserve(results.size());
+	trades.reserve(results.size());
+	std::size_t losses = 0;
+	for (auto &&r: results) {
+		profit.push_back(r.profit);
+		drawdown.push_back(r.drawdown);
+		trades.push_back(r.trades);
+		if (r.profit < 0) losses++;
+	}
+	return json::Object
+			("paths", results.size())
+			("loss_probability", results.empty()?0.0:static_cast<double>(losses)/results.size())
+			("profit", distribution(std::move(profit)))
+			("drawdown", distribution(std::move(drawdown)))
+			("trades", distribution(std::move(trades)));
+}
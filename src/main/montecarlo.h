@@ -0,0 +1,116 @@
+/*
+ * montecarlo.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_MONTECARLO_H_
+#define SRC_MAIN_MONTECARLO_H_
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <imtjson/namedEnum.h>
+#include "backtest.h"
+#include "chart_soa.h"
+
+///Backtests on synthetic price paths
+/**
+ * Paths are generated from log returns of the recorded chart. Every path has the same
+ * length and the same timestamps as the recorded chart. The path is generated to a buffer
+ * of the thread, which is reused for next path, so the memory usage doesn't depend on
+ * count of paths. Only the results of the paths are kept.
+ *
+ * The path is determined by the seed and its index, so the results don't depend on
+ * count of threads.
+ */
+class MonteCarlo {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+
+	enum class Model {
+		///random blocks of recorded log returns
+		bootstrap,
+		///geometric brownian motion with drift and volatility of the recorded chart
+		gbm,
+		///gbm with random jumps
+		jump
+	};
+
+	struct Options {
+		Model model = Model::bootstrap;
+		///count of paths
+		std::size_t paths = 1000;
+		///length of the block (bootstrap)
+		std::size_t block = 60;
+		///probability of jump on a step (jump)
+		double jump_prob = 0.001;
+		///standard deviation of the jump (log), 0 = 10x volatility (jump)
+		double jump_size = 0;
+		std::uint64_t seed = 0;
+		///count of threads (0 = all CPUs)
+		unsigned int threads = 0;
+	};
+
+	struct PathResult {
+		double profit;
+		double drawdown;
+		unsigned int trades;
+	};
+
+	///Called after each path (serialized), return false to stop
+	using ProgressFn = std::function<bool(std::size_t done)>;
+
+	///Initializes the generator
+	/**
+	 * @param chart recorded chart - must stay valid during lifetime of the object, the
+	 * timestamps of the paths are read from it
+	 * @param minfo market info
+	 * @param cfg configuration of the backtests
+	 * @param spread spread used when the spread calculation is disabled
+	 * @param balance initial balance
+	 */
+	MonteCarlo(ondra_shared::StringView<ChartItem> chart,
+			const IStockApi::MarketInfo &minfo,
+			const BacktestControl::Config &cfg,
+			double spread,
+			double balance);
+
+	///Generates the path
+	/**
+	 * @param idx index of the path
+	 * @param opts options
+	 * @param out buffer, it is cleared first
+	 */
+	void generate(std::size_t idx, const Options &opts, ChartSoA &out) const;
+
+	///Runs backtests on all paths
+	/**
+	 * @return results of the paths in order of indexes (paths not finished because
+	 * of stop are removed)
+	 */
+	std::vector<PathResult> run(const Options &opts, ProgressFn progress) const;
+
+	///Distribution of the results (mean, percentiles, probability of loss)
+	static json::Value summarize(const std::vector<PathResult> &results);
+
+protected:
+	ondra_shared::StringView<ChartItem> chart;
+	std::vector<double> returns;
+	double first_price;
+	///log(ask/bid)/2
+	double half_spread;
+	double drift;
+	double volatility;
+	IStockApi::MarketInfo minfo;
+	BacktestControl::Config cfg;
+	double spread;
+	double balance;
+};
+
+extern json::NamedEnum<MonteCarlo::Model> strMonteCarloModel;
+
+
+#endif /* SRC_MAIN_MONTECARLO_H_ */
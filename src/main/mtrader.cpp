@@ -10,6 +10,7 @@
 #include <imtjson/array.h>
 #include <numeric>
 
+#include "alloc_counter.h"
 #include "emulator.h"
 #include "sgn.h"
 
@@ -25,15 +26,21 @@ json::NamedEnum<Dynmult_mode> strDynmult_mode  ({
 MTrader::MTrader(IStockSelector &stock_selector,
 		StoragePtr &&storage,
 		PStatSvc &&statsvc,
-		Config config)
-:stock(selectStock(stock_selector,config,ownedStock))
+		Config config,
+		StoragePtr &&tier_storage)
+:stock(selectStock(stock_selector,config,ownedStock,recorder))
 ,cfg(std::move(config))
 ,storage(std::move(storage))
+,tier_storage(std::move(tier_storage))
 ,statsvc(std::move(statsvc))
+,chart_tiers(cfg.chart_history_days)
 {
 	//probe that broker is valid configured
 	stock.testBroker();
 	magic = this->statsvc->getHash() & 0xFFFFFFFF;
+	magic_id = json::Value(magic);
+	//market info is not known yet, loadState() selects the policy again
+	order_policy = selectOrderPolicy();
 }
 
 
@@ -46,6 +53,8 @@ MTrader::Config MTrader::load(const ondra_shared::IniConfig::Section& ini, bool
 	cfg.spread_calc_mins = ini["spread_calc_hours"].getUInt(24*5)*60;
 	cfg.spread_calc_min_trades = ini["spread_calc_min_trades"].getUInt(8);
 	cfg.spread_calc_max_trades = ini["spread_calc_max_trades"].getUInt(24);
+	cfg.spread_calc_tier = ini["spread_calc_tier"].getUInt(1);
+	cfg.chart_history_days = ini["chart_history_days"].getUInt(365);
 	cfg.pairsymb = ini.mandatory["pair_symbol"].getString();
 
 	cfg.buy_mult = ini["buy_mult"].getNumber(1.0);
@@ -57,7 +66,8 @@ MTrader::Config MTrader::load(const ondra_shared::IniConfig::Section& ini, bool
 	cfg.min_size = ini["min_size"].getNumber(0);
 
 
-	cfg.dry_run = force_dry_run?true:ini["dry_run"].getBool(false);
+	cfg.shadow = ini["shadow"].getBool(false);
+	cfg.dry_run = force_dry_run || cfg.shadow?true:ini["dry_run"].getBool(false);
 	cfg.internal_balance = cfg.dry_run?true:ini["internal_balance"].getBool(false);
 	cfg.detect_manual_trades = ini["detect_manual_trades"].getBool(true);
 
@@ -84,7 +94,13 @@ MTrader::Config MTrader::load(const ondra_shared::IniConfig::Section& ini, bool
 
 	cfg.start_time = ini["start_time"].getUInt(0);
 
+	auto record_file = ini["record_file"];
+	if (record_file.defined()) cfg.record_file = record_file.getPath();
+
 	if (cfg.spread_calc_mins > 1000000) throw std::runtime_error("spread_calc_hours is too big");
+	if (cfg.spread_calc_tier != 1 && cfg.spread_calc_tier != 15 && cfg.spread_calc_tier != 60) throw std::runtime_error("'spread_calc_tier' must be 1, 15 or 60");
+	if (cfg.chart_history_days > 3650) throw std::runtime_error("'chart_history_days' is too big");
+	if (cfg.spread_calc_tier != 1 && cfg.chart_history_days == 0) throw std::runtime_error("'spread_calc_tier' 15 or 60 requires 'chart_history_days' above zero");
 	if (cfg.spread_calc_min_trades > cfg.spread_calc_max_trades) throw std::runtime_error("'spread_calc_min_trades' must bee less then 'spread_calc_max_trades'");
 	if (cfg.spread_calc_max_trades > 24*60) throw std::runtime_error("'spread_calc_max_trades' is too big");
 	if (cfg.acm_factor_buy > 20) throw std::runtime_error("'acum_factor_buy' is too big");
@@ -107,15 +123,20 @@ bool MTrader::Order::isSimilarTo(const Order& other, double step) {
 }
 
 
-IStockApi &MTrader::selectStock(IStockSelector &stock_selector, const Config &conf,	std::unique_ptr<IStockApi> &ownedStock) {
+IStockApi &MTrader::selectStock(IStockSelector &stock_selector, const Config &conf,	std::unique_ptr<IStockApi> &ownedStock, RecordingStockApi *&recorder) {
 	IStockApi *s = stock_selector.getStock(conf.broker);
 	if (s == nullptr) throw std::runtime_error(std::string("Unknown stock market name: ")+std::string(conf.broker));
 	if (conf.dry_run) {
 		ownedStock = std::make_unique<EmulatorAPI>(*s, conf.emulated_currency);
-		return *ownedStock;
-	} else {
-		return *s;
+		s = ownedStock.get();
 	}
+	if (!conf.record_file.empty()) {
+		auto rec = std::make_unique<RecordingStockApi>(*s, std::move(ownedStock), conf.record_file);
+		recorder = rec.get();
+		ownedStock = std::move(rec);
+		s = ownedStock.get();
+	}
+	return *s;
 }
 
 double MTrader::raise_fall(double v, bool raise) const {
@@ -171,6 +192,8 @@ int MTrader::perform() {
 
 	try {
 
+		AllocCounter::Scope allocs;
+		if (recorder) recorder->recordCycle();
 		init();
 
 	double begbal = internal_balance + cfg.external_assets;
@@ -240,29 +263,14 @@ int MTrader::perform() {
 				internal_balance=status.assetBalance - cfg.external_assets;
 			}
 
-			//calculate buy order
-			auto buyorder = calculateOrder(lastTradePrice,
+			//calculate buy and sell order
+			auto [buyorder, sellorder] = calculateOrders(lastTradePrice,
 										  -status.curStep*buy_dynmult*cfg.buy_step_mult,
-										   status.curPrice, status.assetBalance, acm_buy);
-			//calculate sell order
-			auto sellorder = calculateOrder(lastTradePrice,
-					                       status.curStep*sell_dynmult*cfg.sell_step_mult,
-										   status.curPrice, status.assetBalance, acm_sell);
-
-			try {
-				setOrder(orders.buy, buyorder);
-			} catch (std::exception &e) {
-				buy_order_error = e.what();
-				orders.buy = buyorder;
-			}
+										   status.curStep*sell_dynmult*cfg.sell_step_mult,
+										   status.curPrice, status.assetBalance, acm_buy, acm_sell);
 
-			try {
-				setOrder(orders.sell, sellorder);
-			} catch (std::exception &e) {
-				sell_order_error = e.what();
-				orders.sell = sellorder;
-			}
-			//replace order on stockmarket
+			//replace orders on stockmarket (both by single request)
+			setOrders(orders, buyorder, sellorder, buy_order_error, sell_order_error);
 			//remember the orders (keep previous orders as well)
 			std::swap(lastOrders[0],lastOrders[1]);
 			lastOrders[0] = orders;
@@ -321,6 +329,8 @@ int MTrader::perform() {
 
 	}
 
+	IStatSvc::MiscData misc{};
+
 	//report orders to UI
 	statsvc->reportOrders(orders.buy,orders.sell);
 	//report order errors to UI
@@ -348,7 +358,7 @@ int MTrader::perform() {
 			boost = cfg.external_assets*start_price / colateral;
 		}
 
-		statsvc->reportMisc(IStatSvc::MiscData{
+		misc = IStatSvc::MiscData{
 			status.new_trades.empty()?0:sgn(status.new_trades.back().size),
 			calculator.isAchieveMode(),
 			calculator.balance2price(status.assetBalance),
@@ -360,23 +370,35 @@ int MTrader::perform() {
 			min_price,
 			max_price,
 			trades.size()
-		});
+		};
+		statsvc->reportMisc(misc);
 
 	}
 
 	//store current price (to build chart)
 	chart.push_back(status.chartItem);
-	//delete very old data from chart
-	if (chart.size() > cfg.spread_calc_mins)
+	//update downsampled charts
+	if (chart_tiers.push(status.chartItem) && tier_storage) {
+		//the tiers are stored only when a bar is closed, the current bar is rebuilt from the chart
+		tier_storage->store(chart_tiers.toJSON());
+	}
+	//delete very old data from chart - in batches, so the cost of the erase is amortized
+	if (chart.size() > 2*cfg.spread_calc_mins)
 		chart.erase(chart.begin(),chart.end()-cfg.spread_calc_mins);
 
 
 	//if this was first order, the next will not first order
 	first_order = false;
 
+	publishSnapshot(orders, misc, status.curPrice);
+
 	//save state
 	saveState();
 
+	if constexpr(AllocCounter::enabled) {
+		ondra_shared::logDebug("Allocations in cycle: $1", allocs.count());
+	}
+
 	return 0;
 	} catch (std::exception &e) {
 		statsvc->reportError(IStatSvc::ErrorObj(e.what()));
@@ -390,7 +412,7 @@ MTrader::OrderPair MTrader::getOrders() {
 	auto data = stock.getOpenOrders(cfg.pairsymb);
 	for (auto &&x: data) {
 		try {
-			if (x.client_id == magic) {
+			if (x.client_id == magic_id) {
 				Order o(x);
 				if (o.size<0) {
 					if (ret.sell.has_value()) {
@@ -415,35 +437,89 @@ MTrader::OrderPair MTrader::getOrders() {
 	return ret;
 }
 
+bool MTrader::prepareOrder(const std::optional<Order> &orig, Order &neworder, IStockApi::OrderRequest &req) const {
+	if (neworder.price < 0 || neworder.size == 0) return false;
+	neworder.client_id = magic_id;
+	json::Value replaceid;
+	double replaceSize = 0;
+	if (orig.has_value()) {
+		if (orig->isSimilarTo(neworder, minfo.currency_step)) return false;
+		replaceid = orig->id;
+		replaceSize = std::fabs(orig->size);
+	}
+	req = IStockApi::OrderRequest{
+		cfg.pairsymb,
+		neworder.size,
+		neworder.price,
+		neworder.client_id,
+		replaceid,
+		replaceSize
+	};
+	return true;
+}
+
+void MTrader::commitOrder(std::optional<Order> &orig, const Order &neworder, const IStockApi::OrderRequest &req, json::Value placeid) {
+	if (placeid.isNull() || !placeid.defined()) {
+		orig.reset();
+	} else if (placeid != req.replaceId) {
+		orig = neworder;
+	}
+}
+
 void MTrader::setOrder(std::optional<Order> &orig, Order neworder) {
 	try {
-		if (neworder.price < 0 || neworder.size == 0) return;
-		neworder.client_id = magic;
-		json::Value replaceid;
-		double replaceSize = 0;
-		if (orig.has_value()) {
-			if (orig->isSimilarTo(neworder, minfo.currency_step)) return;
-			replaceid = orig->id;
-			replaceSize = std::fabs(orig->size);
-		}
+		IStockApi::OrderRequest req;
+		if (!prepareOrder(orig, neworder, req)) return;
 		json::Value placeid = stock.placeOrder(
-					cfg.pairsymb,
-					neworder.size,
-					neworder.price,
-					neworder.client_id,
-					replaceid,
-					replaceSize);
-		if (placeid.isNull() || !placeid.defined()) {
-			orig.reset();
-		} else if (placeid != replaceid) {
-			orig = neworder;
-		}
+					req.pair,
+					req.size,
+					req.price,
+					req.clientId,
+					req.replaceId,
+					req.replaceSize);
+		commitOrder(orig, neworder, req, placeid);
 	} catch (...) {
 		orig.reset();
 		throw;
 	}
 }
 
+void MTrader::setOrders(OrderPair &orig, const Order &buyorder, const Order &sellorder, std::string &buy_error, std::string &sell_error) {
+	std::optional<Order> *origs[2] = {&orig.buy, &orig.sell};
+	Order neworders[2] = {buyorder, sellorder};
+	std::string *errors[2] = {&buy_error, &sell_error};
+
+	auto &reqs = order_reqs;
+	reqs.clear();
+	unsigned int sides[2];
+	for (unsigned int i = 0; i < 2; i++) {
+		IStockApi::OrderRequest req;
+		if (prepareOrder(*origs[i], neworders[i], req)) {
+			sides[reqs.size()] = i;
+			reqs.push_back(std::move(req));
+		}
+	}
+	if (reqs.empty()) return;
+
+	std::vector<IStockApi::OrderResult> res;
+	try {
+		res = stock.placeOrders(reqs);
+	} catch (std::exception &e) {
+		res.assign(reqs.size(), IStockApi::OrderResult{json::Value(), e.what()});
+	}
+
+	for (std::size_t j = 0; j < reqs.size(); j++) {
+		unsigned int i = sides[j];
+		if (j < res.size() && res[j].error.empty()) {
+			commitOrder(*origs[i], neworders[i], reqs[j], res[j].id);
+		} else {
+			//order is considered as not placed, but it is reported
+			*errors[i] = j < res.size()?res[j].error:std::string("Order was not processed");
+			*origs[i] = neworders[i];
+		}
+	}
+}
+
 
 
 
@@ -475,7 +551,14 @@ MTrader::Status MTrader::getMarketStatus() const {
 
 
 
-	auto step = cfg.force_spread>0?cfg.force_spread:statsvc->calcSpread(chart,cfg,minfo,res.assetBalance,prev_spread);
+	double step;
+	if (cfg.force_spread>0) {
+		step = cfg.force_spread;
+	} else if (cfg.spread_calc_tier>1) {
+		step = statsvc->calcSpread(getChartTier(cfg.spread_calc_tier),cfg,minfo,res.assetBalance,prev_spread);
+	} else {
+		step = statsvc->calcSpread(getChart(),cfg,minfo,res.assetBalance,prev_spread);
+	}
 	res.curStep = step;
 	prev_spread = step;
 
@@ -494,7 +577,8 @@ MTrader::Status MTrader::getMarketStatus() const {
 }
 
 
-MTrader::Order MTrader::calculateOrderFeeLess(
+template<bool accumulate>
+MTrader::Order MTrader::calculateOrderFeeLessT(
 		double prevPrice,
 		double step,
 		double curPrice,
@@ -503,7 +587,6 @@ MTrader::Order MTrader::calculateOrderFeeLess(
 	Order order;
 
 	double newPrice = prevPrice * exp(step);
-	double fact = acm;
 	double mult;
 
 	if (step < 0) {
@@ -523,8 +606,9 @@ MTrader::Order MTrader::calculateOrderFeeLess(
 
 	double newBalance = calculator.price2balance(newPrice);
 	double base = (newBalance - balance);
-	double extra = calculator.calcExtra(prevPrice, newPrice);
-	double size = base +extra*fact;
+	double extra = 0;
+	if constexpr(accumulate) extra = calculator.calcExtra(prevPrice, newPrice);
+	double size = base +extra*acm;
 
 	ondra_shared::logDebug("Set order: step=$1, base_price=$6, price=$2, base=$3, extra=$4, total=$5",step, newPrice, base, extra, size, prevPrice);
 
@@ -538,40 +622,109 @@ MTrader::Order MTrader::calculateOrderFeeLess(
 
 }
 
-MTrader::Order MTrader::calculateOrder(
+template<bool accumulate, bool limits, IStockApi::FeeScheme scheme>
+MTrader::Order MTrader::calculateOrderT(
 		double lastTradePrice,
 		double step,
 		double curPrice,
 		double balance,
 		double acm) const {
 
-	Order order(calculateOrderFeeLess(lastTradePrice, step,curPrice,balance,acm));
+	Order order(calculateOrderFeeLessT<accumulate>(lastTradePrice, step,curPrice,balance,acm));
 
-	if (std::fabs(order.size) < cfg.min_size) {
-		order.size = cfg.min_size*sgn(order.size);
-	}
-	if (std::fabs(order.size) < minfo.min_size) {
-		order.size = minfo.min_size*sgn(order.size);
-	}
-	if (minfo.min_volume) {
-		double vol = std::fabs(order.size * order.price);
-		if (vol < minfo.min_volume) {
-			order.size = minfo.min_volume/order.price*sgn(order.size);
+	if constexpr(limits) {
+		if (std::fabs(order.size) < cfg.min_size) {
+			order.size = cfg.min_size*sgn(order.size);
+		}
+		if (std::fabs(order.size) < minfo.min_size) {
+			order.size = minfo.min_size*sgn(order.size);
+		}
+		if (minfo.min_volume) {
+			double vol = std::fabs(order.size * order.price);
+			if (vol < minfo.min_volume) {
+				order.size = minfo.min_volume/order.price*sgn(order.size);
+			}
 		}
 	}
 	//apply fees
-	minfo.addFees(order.size, order.price);
+	minfo.addFees<scheme>(order.size, order.price);
 
 	//order here
 	return order;
 
 }
 
+template<typename Fn>
+auto MTrader::withOrderPolicy(Fn &&fn) const {
+	auto withScheme = [&](auto accumulate, auto limits) {
+		switch (order_policy.scheme) {
+		default:
+		case IStockApi::currency: return fn(accumulate, limits, std::integral_constant<IStockApi::FeeScheme, IStockApi::currency>());
+		case IStockApi::assets: return fn(accumulate, limits, std::integral_constant<IStockApi::FeeScheme, IStockApi::assets>());
+		case IStockApi::income: return fn(accumulate, limits, std::integral_constant<IStockApi::FeeScheme, IStockApi::income>());
+		case IStockApi::outcome: return fn(accumulate, limits, std::integral_constant<IStockApi::FeeScheme, IStockApi::outcome>());
+		}
+	};
+	auto withLimits = [&](auto accumulate) {
+		return order_policy.limits?withScheme(accumulate, std::true_type()):withScheme(accumulate, std::false_type());
+	};
+	return order_policy.accumulate?withLimits(std::true_type()):withLimits(std::false_type());
+}
+
+MTrader::OrderPolicy MTrader::selectOrderPolicy() const {
+	//sliding_pos.acum only multiplies the factors, so zero factors disable the accumulation
+	return OrderPolicy {
+		cfg.acm_factor_buy != 0 || cfg.acm_factor_sell != 0,
+		cfg.min_size > 0 || minfo.min_size > 0 || minfo.min_volume > 0,
+		minfo.feeScheme
+	};
+}
+
+std::pair<MTrader::Order, MTrader::Order> MTrader::calculateOrders(
+		double lastTradePrice,
+		double buy_step,
+		double sell_step,
+		double curPrice,
+		double balance,
+		double acm_buy,
+		double acm_sell) const {
+	return withOrderPolicy([&](auto accumulate, auto limits, auto scheme) {
+		using Acm = decltype(accumulate);
+		using Lim = decltype(limits);
+		using Sch = decltype(scheme);
+		return std::pair<Order, Order>(
+			calculateOrderT<Acm::value, Lim::value, Sch::value>(lastTradePrice, buy_step, curPrice, balance, acm_buy),
+			calculateOrderT<Acm::value, Lim::value, Sch::value>(lastTradePrice, sell_step, curPrice, balance, acm_sell));
+	});
+}
+
+MTrader::Order MTrader::calculateOrderFeeLess(
+		double prevPrice,
+		double step,
+		double curPrice,
+		double balance,
+		double acm) const {
+	return calculateOrderFeeLessT<true>(prevPrice, step, curPrice, balance, acm);
+}
+
+MTrader::Order MTrader::calculateOrder(
+		double lastTradePrice,
+		double step,
+		double curPrice,
+		double balance,
+		double acm) const {
+	return withOrderPolicy([&](auto accumulate, auto limits, auto scheme) {
+		return calculateOrderT<decltype(accumulate)::value, decltype(limits)::value, decltype(scheme)::value>(
+				lastTradePrice, step, curPrice, balance, acm);
+	});
+}
+
 
 
 
 void MTrader::loadState() {
 	minfo = stock.getMarketInfo(cfg.pairsymb);
+	order_policy = selectOrderPolicy();
 	this->statsvc->setInfo(
 			IStatSvc::Info {
 				cfg.title,
@@ -587,7 +740,16 @@ void MTrader::loadState() {
 	if (storage == nullptr) return;
 	auto st = storage->load();
 	need_load = false;
+	if (recorder) recorder->recordState(st);
+	applyState(st);
+}
 
+void MTrader::importState(json::Value st) {
+	init();
+	applyState(st);
+}
+
+void MTrader::applyState(json::Value st) {
 	bool wastest = false;
 
 	auto curtest = stock.isTest();
@@ -628,6 +790,17 @@ void MTrader::loadState() {
 				});
 			}
 		}
+		auto tierSect = st["chart_tiers"];
+		if (tierSect.defined()) {
+			chart_tiers.fromJSON(tierSect);
+			//state from older version - move the tiers to their storage
+			if (tier_storage) tier_storage->store(tierSect);
+		} else if (tier_storage) {
+			tierSect = tier_storage->load();
+			if (tierSect.defined()) chart_tiers.fromJSON(tierSect);
+		}
+		//bars after the stored ones are built from the chart
+		chart_tiers.catchUp(chart);
 		{
 			auto trSect = st["trades"];
 			if (trSect.defined()) {
@@ -669,10 +842,19 @@ void MTrader::loadState() {
 	if (internal_balance == 0) {
 		if (!trades.empty()) internal_balance = trades.back().balance- cfg.external_assets;
 	}
+	trades_json = json::Value();
 }
 
 void MTrader::saveState() {
 	if (storage == nullptr) return;
+	storage->store(exportState(tier_storage == nullptr));
+}
+
+json::Value MTrader::exportState() const {
+	return exportState(true);
+}
+
+json::Value MTrader::exportState(bool tiers) const {
 	json::Object obj;
 
 	obj.set("version",2);
@@ -690,33 +872,33 @@ void MTrader::saveState() {
 	}
 	{
 		auto ch = obj.array("chart");
-		for (auto &&itm: chart) {
+		for (auto &&itm: getChart()) {
 			ch.push_back(json::Object("time", itm.time)
 				  ("ask",itm.ask)
 				  ("bid",itm.bid)
 				  ("last",itm.last));
 		}
 	}
-	{
-		auto tr = obj.array("trades");
+	if (tiers) obj.set("chart_tiers", chart_tiers.toJSON());
+	if (!trades_json.defined()) {
+		json::Array tr;
 		for (auto &&itm:trades) {
 			tr.push_back(itm.toJSON());
 		}
+		trades_json = tr;
 	}
+	obj.set("trades", trades_json);
 	obj.set("calc", calculator.toJSON());
 	obj.set("orders", {lastOrders[0].toJSON(),lastOrders[1].toJSON()});
-	storage->store(obj);
+	return obj;
 }
 
-MTrader::CalcRes MTrader::calc_min_max_range() {
+MTrader::CalcRes MTrader::calc_min_max_range(const Config &cfg, double avail_assets, double avail_money, double cur_price) {
 
 	CalcRes res {};
-	loadState();
-
-
-	res.avail_assets = stock.getBalance(minfo.asset_symbol);
-	res.avail_money = stock.getBalance(minfo.currency_symbol);
-	res.cur_price = stock.getTicker(cfg.pairsymb).last;
+	res.avail_assets = avail_assets;
+	res.avail_money = avail_money;
+	res.cur_price = cur_price;
 	res.assets = res.avail_assets+cfg.external_assets;
 	res.value = res.assets * res.cur_price;
 	res.max_price = pow2((res.assets * sqrt(res.cur_price))/(res.assets -res.avail_assets));
@@ -727,8 +909,19 @@ MTrader::CalcRes MTrader::calc_min_max_range() {
 
 }
 
+std::pair<double, double> MTrader::getBalances() {
+	if (need_load) loadState();
+	return {stock.getBalance(minfo.asset_symbol), stock.getBalance(minfo.currency_symbol)};
+}
+
+double MTrader::getCurPrice() {
+	if (need_load) loadState();
+	return stock.getTicker(cfg.pairsymb).last;
+}
+
 void MTrader::mergeTrades(std::size_t fromPos) {
 	if (fromPos) --fromPos;
+	trade_ids.truncate(fromPos);
 	auto wr = trades.begin()+fromPos;
 	auto rd = wr;
 	auto end = trades.end();
@@ -757,16 +950,16 @@ void MTrader::mergeTrades(std::size_t fromPos) {
 
 bool MTrader::eraseTrade(std::string_view id, bool trunc) {
 	if (need_load) loadState();
-	auto iter = std::find_if(trades.begin(), trades.end(), [&](const IStockApi::Trade &tr) {
-		json::String s = tr.id.toString();
-		return s.str() == id;
-	});
-	if (iter == trades.end()) return false;
+	auto pos = trade_ids.find(trades, [](const TWBItem &tr) {return tr.id;}, id);
+	if (!pos.has_value()) return false;
+	auto iter = trades.begin() + *pos;
+	trade_ids.truncate(*pos);
 	if (trunc) {
 		trades.erase(iter, trades.end());
 	} else {
 		trades.erase(iter);
 	}
+	trades_json = json::Value();
 	saveState();
 	return true;
 }
@@ -832,6 +1025,7 @@ MTrader::PTResult MTrader::processTrades(Status &st,bool first_trade) {
 		sell_trade = sell_trade || t.eff_size < 0;
 
 		trades.push_back(TWBItem(t, st.assetBalance, manual || calculator.isAchieveMode()));
+		trades_json = json::Value();
 	}
 
 
@@ -867,6 +1061,8 @@ void MTrader::reset() {
 	if (trades.size() > 1) {
 		trades.erase(trades.begin(), trades.end()-1);
 	}
+	trade_ids.clear();
+	trades_json = json::Value();
 	saveState();
 }
 
@@ -900,7 +1096,40 @@ void MTrader::repair() {
 }
 
 ondra_shared::StringView<IStatSvc::ChartItem> MTrader::getChart() const {
-	return chart;
+	ondra_shared::StringView<IStatSvc::ChartItem> res(chart);
+	if (res.length > cfg.spread_calc_mins) res = res.substr(res.length - cfg.spread_calc_mins);
+	return res;
+}
+
+std::vector<IStatSvc::ChartItem> MTrader::getChartTier(unsigned int minutes) const {
+	if (minutes == 1) {
+		auto c = getChart();
+		return std::vector<IStatSvc::ChartItem>(c.begin(), c.end());
+	}
+	int idx = chart_tiers.findTier(minutes);
+	if (idx < 0) throw std::runtime_error("Chart resolution is not available (use 1, 15 or 60)");
+	return chart_tiers.toChart(idx);
+}
+
+void MTrader::publishSnapshot(const OrderPair &orders, const IStatSvc::MiscData &misc, double price) {
+	if (!pub->requested.exchange(false, std::memory_order_relaxed)) {
+		//nobody asked, the previous snapshot would be outdated
+		if (pub->snapshot != nullptr) std::atomic_store(&pub->snapshot, PSnapshot());
+		return;
+	}
+	auto chart = getChart();
+	auto first_trade = trades.size() > snapshotTrades?trades.end()-snapshotTrades:trades.begin();
+	auto snap = std::make_shared<Snapshot>();
+	snap->chart.assign(chart.begin(), chart.end());
+	snap->trades.assign(first_trade, trades.end());
+	snap->calculator = calculator;
+	snap->orders = orders;
+	snap->misc = misc;
+	snap->minfo = minfo;
+	snap->price = price;
+	snap->spread = prev_spread;
+	snap->internal_balance = internal_balance;
+	std::atomic_store(&pub->snapshot, PSnapshot(std::move(snap)));
 }
 
 double MTrader::getLastSpread() const {
@@ -7,15 +7,20 @@
 
 #ifndef SRC_MAIN_MTRADER_H_
 #define SRC_MAIN_MTRADER_H_
+#include <atomic>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <type_traits>
 
 #include <shared/ini_config.h>
 #include <imtjson/namedEnum.h>
 #include "calculator.h"
+#include "chart_tiers.h"
 #include "istatsvc.h"
 #include "storage.h"
+#include "stock_recorder.h"
+#include "trade_id_index.h"
 #include "report.h"
 
 class IStockApi;
@@ -63,15 +68,22 @@ struct MTrader_Config {
 	unsigned int spread_calc_mins;
 	unsigned int spread_calc_min_trades;
 	unsigned int spread_calc_max_trades;
+	unsigned int spread_calc_tier;
+
+	unsigned int chart_history_days;
 
 
 
 	bool dry_run;
+	///shadow trader - emulated (dry_run) on the feed shared with other traders of the broker (see SharedFeedApi)
+	bool shadow;
 	bool internal_balance;
 	bool detect_manual_trades;
 
 	std::size_t start_time;
 
+	///when not empty, all calls of the broker are recorded to this file (see RecordingStockApi)
+	std::string record_file;
 
 
 
@@ -108,10 +120,20 @@ public:
 	};
 
 
+	///Creates trader
+	/**
+	 * @param stock_selector selector of the broker
+	 * @param storage storage of the state
+	 * @param statsvc statistics
+	 * @param config configuration
+	 * @param tier_storage optional storage of the chart tiers. The tiers are stored
+	 * only when a bar is closed. If not given, the tiers are stored with the state
+	 */
 	MTrader(IStockSelector &stock_selector,
 			StoragePtr &&storage,
 			PStatSvc &&statsvc,
-			Config config);
+			Config config,
+			StoragePtr &&tier_storage = StoragePtr());
 
 
 	///Returns true, if trade was detected, or false, if not
@@ -121,6 +143,17 @@ public:
 
 	OrderPair getOrders();
 	void setOrder(std::optional<Order> &orig, Order neworder);
+	///Sets buy and sell order by single request to the broker
+	/**
+	 * @param orig current orders, updated
+	 * @param buyorder new buy order
+	 * @param sellorder new sell order
+	 * @param buy_error receives error of the buy order
+	 * @param sell_error receives error of the sell order
+	 *
+	 * The failed order is stored to the orig as it would be placed (so it is reported)
+	 */
+	void setOrders(OrderPair &orig, const Order &buyorder, const Order &sellorder, std::string &buy_error, std::string &sell_error);
 
 
 	using ChartItem = IStatSvc::ChartItem;
@@ -159,6 +192,34 @@ public:
 			double balance,
 			double acm) const;
 
+	///Policies of the order calculation, which don't change between cycles
+	struct OrderPolicy {
+		///accumulation is enabled by config
+		bool accumulate;
+		///there is minimal size or volume
+		bool limits;
+		///fee scheme of the market
+		IStockApi::FeeScheme scheme;
+	};
+
+	///Selects the order policy for the current config and market
+	OrderPolicy selectOrderPolicy() const;
+
+	///Calculates buy and sell order
+	/**
+	 * The calculation is specialized for the order policy. The specialization is
+	 * selected once for both orders.
+	 *
+	 * @return buy order and sell order
+	 */
+	std::pair<Order, Order> calculateOrders(double lastTradePrice,
+			double buy_step,
+			double sell_step,
+			double curPrice,
+			double balance,
+			double acm_buy,
+			double acm_sell) const;
+
 	const Config &getConfig() {return cfg;}
 
 	const IStockApi::MarketInfo getMarketInfo() const {return minfo;}
@@ -174,23 +235,81 @@ public:
 
 	};
 
-	CalcRes calc_min_max_range();
+	///Calculates the trading range
+	/**
+	 * The function doesn't access the trader, it can be called from any thread
+	 * @param cfg configuration of the trader
+	 * @param avail_assets available assets on the account
+	 * @param avail_money available currency on the account
+	 * @param cur_price current price
+	 */
+	static CalcRes calc_min_max_range(const Config &cfg, double avail_assets, double avail_money, double cur_price);
+	///Returns balances of the assets and the currency as the trader sees them (emulated in dry run)
+	std::pair<double, double> getBalances();
+	///Returns current price of the pair from the trader's broker
+	double getCurPrice();
 
 	bool eraseTrade(std::string_view id, bool trunc);
 	void reset();
 	void repair();
 	void achieve_balance(double price, double balance);
 	ondra_shared::StringView<IStatSvc::ChartItem> getChart() const;
+	///Returns chart of given resolution
+	/**
+	 * @param minutes resolution in minutes (1, 15 or 60)
+	 * @return chart built from closing prices of the tier's bars
+	 */
+	std::vector<IStatSvc::ChartItem> getChartTier(unsigned int minutes) const;
 	double getLastSpread() const;
 	double getInternalBalance() const;
 	void setInternalBalance(double v);
 
+	///Returns complete state of the trader (the same content which is saved to the storage)
+	json::Value exportState() const;
+	///Initializes the trader and replaces its state by the state returned by exportState()
+	void importState(json::Value st);
+
+	///Consistent copy of the trader's state published at the end of perform()
+	/** The snapshot is published only when it has been requested by getSnapshot()
+	 * since the previous perform(), so the trader doesn't copy the chart every cycle */
+	struct Snapshot {
+		///part of the chart used for the spread calculation
+		std::vector<ChartItem> chart;
+		///last trades (at most snapshotTrades)
+		IStockApi::TWBHistory trades;
+		Calculator calculator;
+		///current orders
+		OrderPair orders;
+		IStatSvc::MiscData misc;
+		IStockApi::MarketInfo minfo;
+		double price;
+		double spread;
+		double internal_balance;
+	};
+	using PSnapshot = std::shared_ptr<const Snapshot>;
+
+	static constexpr std::size_t snapshotTrades = 100;
+
+	///Returns the snapshot published by the last perform()
+	/**
+	 * The function can be called from any thread without blocking the trader. It also
+	 * requests the snapshot from the next perform().
+	 * @return snapshot, or nullptr if the snapshot was not requested before the last
+	 * perform(). Then the caller has to copy the state in the trader's thread
+	 */
+	PSnapshot getSnapshot() const {
+		pub->requested.store(true, std::memory_order_relaxed);
+		return std::atomic_load(&pub->snapshot);
+	}
+
 protected:
 	std::unique_ptr<IStockApi> ownedStock;
+	RecordingStockApi *recorder = nullptr;
 	IStockApi &stock;
 	Config cfg;
 	IStockApi::MarketInfo minfo;
 	StoragePtr storage;
+	StoragePtr tier_storage;
 	PStatSvc statsvc;
 	OrderPair lastOrders[2];
 	bool need_load = true;
@@ -201,7 +320,10 @@ protected:
 	using TWBItem = IStockApi::TradeWithBalance;
 
 	std::vector<ChartItem> chart;
+	ChartTiers chart_tiers;
 	IStockApi::TWBHistory trades;
+	///index of trade ids (eraseTrade)
+	TradeIdIndex trade_ids;
 
 	double buy_dynmult=1.0;
 	double sell_dynmult=1.0;
@@ -209,10 +331,29 @@ protected:
 	mutable double prev_spread=0.01;
 	double prev_calc_ref = 0;
 	double currency_balance_cache = 0;
+	///order policy selected by selectOrderPolicy(), updated when the market info is loaded
+	OrderPolicy order_policy;
 	size_t magic = 0;
+	///magic as json - it is compared and sent with every order, so it is converted once
+	json::Value magic_id;
+	///serialized trades for exportState(), undefined after the trades changed
+	mutable json::Value trades_json;
+	///order requests of setOrders(), kept between cycles to reuse the capacity
+	std::vector<IStockApi::OrderRequest> order_reqs;
 
 	void loadState();
 	void saveState();
+	json::Value exportState(bool tiers) const;
+	void applyState(json::Value st);
+	void publishSnapshot(const OrderPair &orders, const IStatSvc::MiscData &misc, double price);
+
+	struct Published {
+		PSnapshot snapshot;
+		///set by getSnapshot(), the next perform() publishes the snapshot
+		std::atomic<bool> requested{false};
+	};
+	///allocated separately, so the trader remains movable
+	std::unique_ptr<Published> pub = std::make_unique<Published>();
 
 
 	double range_max_price(Status st, double &avail_assets);
@@ -221,7 +362,7 @@ protected:
 	double raise_fall(double v, bool raise) const;
 
 
-	static IStockApi &selectStock(IStockSelector &stock_selector, const Config &conf, std::unique_ptr<IStockApi> &ownedStock);
+	static IStockApi &selectStock(IStockSelector &stock_selector, const Config &conf, std::unique_ptr<IStockApi> &ownedStock, RecordingStockApi *&recorder);
 	std::size_t testStartTime;
 
 	struct PTResult {
@@ -232,6 +373,33 @@ protected:
 	void mergeTrades(std::size_t fromPos);
 
 	Calculator initSlidingCalc(double refprice, double cur, double assets);
+
+	///Prepares request to place the order, returns false if the order doesn't need to be placed
+	bool prepareOrder(const std::optional<Order> &orig, Order &neworder, IStockApi::OrderRequest &req) const;
+	///Updates the order by result of the request
+	void commitOrder(std::optional<Order> &orig, const Order &neworder, const IStockApi::OrderRequest &req, json::Value placeid);
+
+	///Calculates order without fees and limits
+	/**
+	 * @tparam accumulate false if the accumulation is disabled by config (acm is ignored)
+	 */
+	template<bool accumulate>
+	Order calculateOrderFeeLessT(double lastTradePrice, double step, double curPrice, double balance, double acm) const;
+	///Calculates order, specialized for the policies of the config and the market
+	/**
+	 * @tparam accumulate false if the accumulation is disabled by config
+	 * @tparam limits false if there is no minimal size or volume
+	 * @tparam scheme fee scheme of the market
+	 */
+	template<bool accumulate, bool limits, IStockApi::FeeScheme scheme>
+	Order calculateOrderT(double lastTradePrice, double step, double curPrice, double balance, double acm) const;
+	///Calls the function with the order policy converted to compile-time constants
+	/**
+	 * @param fn generic function, which receives std::integral_constant arguments
+	 * (accumulate, limits, scheme)
+	 */
+	template<typename Fn>
+	auto withOrderPolicy(Fn &&fn) const;
 	void update_dynmult(bool buy_trade,bool sell_trade);
 
 };
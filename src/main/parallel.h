@@ -0,0 +1,65 @@
+/*
+ * parallel.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_PARALLEL_H_
+#define SRC_MAIN_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///Returns default count of threads for parallel jobs
+inline unsigned int defaultThreadCount() {
+	return std::max(1U, std::thread::hardware_concurrency());
+}
+
+///Runs the function for every index from 0 to count-1 on a pool of threads
+/**
+ * Jobs are picked by the threads in order of indexes. The function returns after
+ * all jobs are finished. The first exception thrown by a job is rethrown to the caller,
+ * remaining jobs are not started
+ *
+ * @param count count of jobs
+ * @param threads count of threads (0 = defaultThreadCount())
+ * @param fn function called with index of the job and index of the thread. It is called
+ * from the threads of the pool
+ */
+template<typename Fn>
+void parallel_for(std::size_t count, unsigned int threads, Fn &&fn) {
+	if (threads == 0) threads = defaultThreadCount();
+	threads = static_cast<unsigned int>(std::min<std::size_t>(threads, count));
+	std::atomic<std::size_t> next(0);
+	std::exception_ptr exp;
+	std::mutex lock;
+
+	auto worker = [&](unsigned int thrid) {
+		std::size_t idx;
+		while ((idx = next.fetch_add(1)) < count) {
+			try {
+				fn(idx, thrid);
+			} catch (...) {
+				std::lock_guard<std::mutex> _(lock);
+				if (exp == nullptr) exp = std::current_exception();
+				next = count;
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve(threads);
+	for (unsigned int i = 1; i < threads; i++) pool.emplace_back(worker, i);
+	//the calling thread works too
+	if (threads) worker(0);
+	for (auto &&t: pool) t.join();
+	if (exp != nullptr) std::rethrow_exception(exp);
+}
+
+
+
+#endif /* SRC_MAIN_PARALLEL_H_ */
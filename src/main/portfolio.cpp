@@ -0,0 +1,79 @@
+/*
+ * portfolio.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "portfolio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "parallel.h"
+
+PortfolioBacktest::PortfolioBacktest(std::vector<Member> &&members, std::uint64_t resolution)
+	:members(std::move(members)),resolution(std::max<std::uint64_t>(resolution,1)) {}
+
+void PortfolioBacktest::run(unsigned int threads, ProgressFn progress) {
+	results.clear();
+	results.resize(members.size());
+	std::mutex lock;
+	parallel_for(members.size(), threads, [&](std::size_t idx, unsigned int) {
+		const Member &m = members[idx];
+		MemberResult &r = results[idx];
+		BacktestControl bt(m.minfo, std::make_unique<BacktestStatSvc>(m.cfg.calc_spread_minutes),
+				m.cfg, m.chart, m.spread, m.balance);
+		r.max_exposure = 0;
+		while (bt.step()) {
+			//the mirrored half has own time axis per member, it can't be merged
+			if (bt.isMirrored()) continue;
+			Sample s = bt.getSample();
+			r.max_exposure = std::max(r.max_exposure, std::abs(s.exposure));
+			s.time = s.time / resolution * resolution;
+			if (!r.curve.empty() && r.curve.back().time == s.time) r.curve.back() = s;
+			else r.curve.push_back(s);
+		}
+		r.result = bt.getResult();
+		if (progress) {
+			std::lock_guard<std::mutex> _(lock);
+			progress(idx, r);
+		}
+	});
+}
+
+std::vector<PortfolioBacktest::Sample> PortfolioBacktest::merge() const {
+	std::vector<std::uintptr_t> grid;
+	for (auto &&r: results) {
+		for (auto &&s: r.curve) grid.push_back(s.time);
+	}
+	std::sort(grid.begin(), grid.end());
+	grid.erase(std::unique(grid.begin(), grid.end()), grid.end());
+
+	std::vector<Sample> res;
+	res.reserve(grid.size());
+	for (auto t: grid) res.push_back(Sample{t,0,0});
+	for (auto &&r: results) {
+		//curves are sorted, walk both at once
+		auto iter = r.curve.begin();
+		Sample last{0,0,0};
+		for (auto &&s: res) {
+			while (iter != r.curve.end() && iter->time <= s.time) last = *iter++;
+			s.equity += last.equity;
+			s.exposure += last.exposure;
+		}
+	}
+	return res;
+}
+
+PortfolioBacktest::Summary PortfolioBacktest::summarize(const std::vector<Sample> &curve) {
+	Summary res{0,0,0};
+	double peak = 0;
+	for (auto &&s: curve) {
+		peak = std::max(peak, s.equity);
+		res.drawdown = std::max(res.drawdown, peak - s.equity);
+		res.max_exposure = std::max(res.max_exposure, std::abs(s.exposure));
+	}
+	if (!curve.empty()) res.profit = curve.back().equity;
+	return res;
+}
@@ -0,0 +1,98 @@
+/*
+ * portfolio.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_PORTFOLIO_H_
+#define SRC_MAIN_PORTFOLIO_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "backtest.h"
+
+///Backtest of multiple traders
+/**
+ * Every trader is backtested on its own chart by its own broker. Backtests run in
+ * parallel. The equity and the exposure of every trader are sampled on a common
+ * time grid, so the curves can be summed to the curves of the whole portfolio.
+ *
+ * Only the forward half of each backtest is sampled. The first half plays the chart
+ * backwards with times mirrored around the start of the member's own chart, so it
+ * can't be aligned with other members. The forward half uses the real time of the chart.
+ *
+ * All traders should use the same currency, otherwise the sums have no meaning.
+ */
+class PortfolioBacktest {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+	using Sample = BacktestControl::Sample;
+
+	struct Member {
+		std::string name;
+		IStockApi::MarketInfo minfo;
+		BacktestControl::Config cfg;
+		///chart - must stay valid during the backtest
+		ondra_shared::StringView<ChartItem> chart;
+		double spread;
+		double balance;
+	};
+
+	struct MemberResult {
+		BacktestControl::Result result;
+		double max_exposure;
+		///samples at the grid (the last sample of each grid interval)
+		std::vector<Sample> curve;
+	};
+
+	struct Summary {
+		double profit;
+		///maximum drawdown of the combined equity
+		double drawdown;
+		///maximum of the combined exposure
+		double max_exposure;
+	};
+
+	///Called when the member is finished (serialized)
+	using ProgressFn = std::function<void(std::size_t idx, const MemberResult &)>;
+
+	///Initializes the backtest
+	/**
+	 * @param members traders
+	 * @param resolution interval of the grid in milliseconds
+	 */
+	PortfolioBacktest(std::vector<Member> &&members, std::uint64_t resolution);
+
+	///Runs all backtests
+	/**
+	 * @param threads count of threads (0 = all CPUs)
+	 * @param progress function called when the member is finished
+	 */
+	void run(unsigned int threads, ProgressFn progress);
+
+	///Merges curves of all members
+	/**
+	 * The value of the member at a grid point is the last sample at or before the point. Members which
+	 * didn't start yet count as zero
+	 *
+	 * @return combined curve
+	 */
+	std::vector<Sample> merge() const;
+
+	static Summary summarize(const std::vector<Sample> &curve);
+
+	const Member &getMember(std::size_t idx) const {return members[idx];}
+	const MemberResult &getResult(std::size_t idx) const {return results[idx];}
+	std::size_t size() const {return members.size();}
+
+protected:
+	std::vector<Member> members;
+	std::vector<MemberResult> results;
+	std::uint64_t resolution;
+};
+
+
+#endif /* SRC_MAIN_PORTFOLIO_H_ */
@@ -10,6 +10,8 @@
 #include <imtjson/value.h>
 #include <imtjson/object.h>
 #include <imtjson/array.h>
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <numeric>
 
@@ -17,6 +19,8 @@
 #include "../shared/logOutput.h"
 #include "../shared/range.h"
 #include "../shared/stdLogOutput.h"
+#include "calculator.h"
+#include "gzip.h"
 #include "sgn.h"
 
 using ondra_shared::logError;
@@ -43,9 +47,283 @@ void Report::genReport() {
 	st.set("time", std::chrono::duration_cast<std::chrono::milliseconds>(
 					std::chrono::system_clock::now().time_since_epoch()
 				   ).count());
-	st.set("log", logLines);
-	while (logLines.size()>30) logLines.erase(0);
-	report->store(st);
+	st.set("log", exportLog());
+	st.set("log_seq", logRing.lastSeq());
+	st.set("rev", revision);
+	json::Value dlt = genDelta(revision>deltaDepth?revision-deltaDepth:0);
+	if (report != nullptr) report->store(st);
+	if (delta != nullptr) delta->store(dlt);
+	if (publish_enabled) {
+		PPublished r = publish(st);
+		PPublished d = publish(dlt);
+		std::lock_guard<std::mutex> _(pubLock);
+		pubReport = r;
+		pubDelta = d;
+	}
+	if (shards_enabled) genShards();
+	sendEvent("rev", Object("rev", revision));
+	++revision;
+}
+
+Report::PPublished Report::publish(json::Value data) const {
+	auto p = std::make_shared<Published>();
+	p->rev = revision;
+	p->etag = "\""+etagPrefix+std::to_string(revision)+"\"";
+	p->content = std::string(data.stringify().str());
+	p->gzip = gzipCompress(p->content);
+	return p;
+}
+
+Report::PPublished Report::getPublishedReport() const {
+	std::lock_guard<std::mutex> _(pubLock);
+	return pubReport;
+}
+
+Report::PPublished Report::getPublishedDelta() const {
+	std::lock_guard<std::mutex> _(pubLock);
+	return pubDelta;
+}
+
+void Report::enableShards(std::optional<StorageFactory> &&files) {
+	shards_enabled = true;
+	shardFiles = std::move(files);
+	if (shardFiles.has_value()) shardIndex = shardFiles->create("report_index.json");
+}
+
+Report::PPublished Report::getPublishedIndex() const {
+	std::lock_guard<std::mutex> _(pubLock);
+	return pubIndex;
+}
+
+Report::PPublished Report::getPublishedShard(const std::string &name) const {
+	std::lock_guard<std::mutex> _(pubLock);
+	auto iter = pubShards.find(name);
+	if (iter == pubShards.end()) return nullptr;
+	else return iter->second;
+}
+
+std::string Report::shardName(StrViewA symb) {
+	static const char hexchr[] = "0123456789ABCDEF";
+	std::string out("shard_");
+	for (char c: symb) {
+		if (isalnum(static_cast<unsigned char>(c)) || c == '-') {
+			out.push_back(c);
+		} else {
+			//escape other characters, so names are always unique
+			unsigned char uc = static_cast<unsigned char>(c);
+			out.push_back('_');
+			out.push_back(hexchr[uc >> 4]);
+			out.push_back(hexchr[uc & 0xF]);
+		}
+	}
+	out.append(".json");
+	return out;
+}
+
+std::size_t Report::shardRevision(const std::string &symb) const {
+	std::size_t rev = 0;
+	for (const RevMap *m: {&chartRev, &orderRev, &infoRev, &priceRev, &miscRev}) {
+		auto iter = m->find(symb);
+		if (iter != m->end()) rev = std::max(rev, iter->second);
+	}
+	return rev;
+}
+
+json::Value Report::genShard(const std::string &symb, std::size_t rev) const {
+	Object sh;
+	sh.set("rev", rev);
+	sh.set("symb", symb);
+	auto trd = tradeMap.find(symb);
+	sh.set("chart", trd == tradeMap.end()?json::Value(json::array):trd->second);
+	{
+		auto out = sh.array("orders");
+		for (auto &&ord : orderMap) {
+			if (ord.second.size && ord.first.symb == symb) {
+				out.push_back(Object
+						("dir",static_cast<int>(ord.first.dir))
+						("size",ord.second.size)
+						("price",ord.second.price)
+				);
+			}
+		}
+	}
+	auto info = infoMap.find(symb);
+	if (info != infoMap.end()) sh.set("info", info->second);
+	auto price = priceMap.find(symb);
+	if (price != priceMap.end()) sh.set("price", price->second);
+	auto misc = miscMap.find(symb);
+	if (misc != miscMap.end()) {
+		auto erritr = errorMap.find(symb);
+		Value err = erritr == errorMap.end()?Value():erritr->second;
+		sh.set("misc", misc->second.replace("error", err));
+	}
+	return sh;
+}
+
+void Report::genShards() {
+	Object idx;
+	idx.set("rev", revision);
+	idx.set("interval", interval_in_ms);
+	idx.set("time", std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::system_clock::now().time_since_epoch()
+				   ).count());
+	idx.set("log", exportLog());
+	idx.set("log_seq", logRing.lastSeq());
+	std::vector<std::pair<std::string, PPublished> > newShards;
+	{
+		auto shards = idx.object("shards");
+		for (auto &&rec: infoMap) {
+			const std::string &symb = rec.first;
+			std::size_t rev = shardRevision(symb);
+			std::string fname = shardName(symb);
+			shards.set(symb, Object("rev", rev)("file", fname));
+			std::size_t &gen = shardGen[symb];
+			//shard is not dirty
+			if (gen == rev) continue;
+			gen = rev;
+			json::Value shard = genShard(symb, rev);
+			if (shardFiles.has_value()) {
+				StoragePtr &stor = shardStorage[fname];
+				if (stor == nullptr) stor = shardFiles->create(fname);
+				stor->store(shard);
+			}
+			if (publish_enabled) newShards.emplace_back(fname, publish(shard));
+		}
+	}
+	if (shardIndex != nullptr) shardIndex->store(idx);
+	if (publish_enabled) {
+		PPublished pidx = publish(idx);
+		std::lock_guard<std::mutex> _(pubLock);
+		for (auto &&s: newShards) pubShards[s.first] = s.second;
+		pubIndex = pidx;
+	}
+}
+
+json::Value Report::genDelta(std::size_t since) const {
+
+	auto changed = [&](const RevMap &map, const std::string &symb) {
+		auto iter = map.find(symb);
+		return iter != map.end() && iter->second > since;
+	};
+
+	Object st;
+	st.set("rev", revision);
+	st.set("base", since);
+	{
+		auto out = st.object("charts");
+		for (auto &&rec: tradeMap) {
+			if (!changed(chartRev, rec.first)) continue;
+			json::Value records = rec.second;
+			std::size_t cnt = records.size();
+			std::size_t pos = cnt;
+			auto riter = recordRev.find(rec.first);
+			if (riter != recordRev.end()) {
+				const auto &revs = riter->second;
+				for (std::size_t i = 0; i < cnt && i < revs.size(); i++) {
+					if (revs[i] > since) {pos = i; break;}
+				}
+			}
+			out.set(rec.first, chartChange(records, pos));
+		}
+	}
+	{
+		auto symbs = st.array("orders_symb");
+		for (auto &&rec: orderRev) {
+			if (rec.second > since) symbs.push_back(rec.first);
+		}
+		auto out = st.array("orders");
+		for (auto &&ord : orderMap) {
+			if (ord.second.size && changed(orderRev, ord.first.symb)) {
+				out.push_back(Object
+						("symb",ord.first.symb)
+						("dir",static_cast<int>(ord.first.dir))
+						("size",ord.second.size)
+						("price",ord.second.price)
+				);
+			}
+		}
+	}
+	{
+		auto out = st.object("info");
+		for (auto &&rec: infoMap) {
+			if (changed(infoRev, rec.first)) out.set(rec.first, rec.second);
+		}
+	}
+	{
+		auto out = st.object("prices");
+		for (auto &&rec: priceMap) {
+			if (changed(priceRev, rec.first)) out.set(rec.first, rec.second);
+		}
+	}
+	{
+		auto out = st.object("misc");
+		for (auto &&rec: miscMap) {
+			if (changed(miscRev, rec.first)) {
+				auto erritr = errorMap.find(rec.first);
+				Value err = erritr == errorMap.end()?Value():erritr->second;
+				out.set(rec.first, rec.second.replace("error", err));
+			}
+		}
+	}
+	st.set("interval", interval_in_ms);
+	st.set("time", std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::system_clock::now().time_since_epoch()
+				   ).count());
+	st.set("log", exportLog());
+	st.set("log_seq", logRing.lastSeq());
+	return st;
+}
+
+json::Value Report::chartChange(json::Value records, std::size_t pos) {
+	std::size_t cnt = records.size();
+	//client replaces records from given time, so include records with the same time
+	while (pos > 0 && pos < cnt && records[pos-1]["time"] == records[pos]["time"]) --pos;
+	Array chg;
+	for (std::size_t i = pos; i < cnt; i++) chg.push_back(records[i]);
+	Value from;
+	if (pos < cnt) from = records[pos]["time"];
+	else if (cnt) from = records[cnt-1]["time"].getUInt()+1;
+	else from = nullptr;
+	return Object
+			("trim", cnt?records[0]["time"]:Value(nullptr))
+			("from", from)
+			("records", chg);
+}
+
+void Report::markChange(RevMap &map, StrViewA symb) {
+	map[symb] = revision;
+}
+
+std::size_t Report::markRecords(StrViewA symb, json::Value records) {
+	json::Value prev = tradeMap[symb];
+	std::vector<std::size_t> &revs = recordRev[symb];
+	std::size_t pcnt = prev.size();
+	std::size_t cnt = records.size();
+	std::size_t ofs = 0;
+	//skip records which left the window
+	if (cnt) {
+		std::uintptr_t first = records[0]["time"].getUInt();
+		while (ofs < pcnt && prev[ofs]["time"].getUInt() < first) ++ofs;
+	}
+	std::vector<std::size_t> newrevs;
+	newrevs.reserve(cnt);
+	std::size_t pos = cnt;
+	for (std::size_t i = 0; i < cnt; i++) {
+		std::size_t j = i + ofs;
+		if (pos == cnt && j < pcnt && prev[j] == records[i]) {
+			newrevs.push_back(j < revs.size()?revs[j]:revision);
+		} else {
+			if (pos == cnt) pos = i;
+			newrevs.push_back(revision);
+		}
+	}
+	revs.swap(newrevs);
+	if (pos < cnt || pcnt - ofs != cnt) {
+		markChange(chartRev, symb);
+		return pos;
+	} else {
+		return no_change;
+	}
 }
 
 
@@ -67,16 +345,33 @@ void Report::setOrders(StrViewA symb, const std::optional<IStockApi::Order> &buy
 	OKey buyKey {symb, buyid};
 	OKey sellKey {symb, -buyid};
 
+	OValue buyVal {0,0}, sellVal {0,0};
 	if (buy.has_value()) {
-		orderMap[buyKey] = {inverted?1.0/buy->price:buy->price, buy->size*buyid};
-	} else{
-		orderMap[buyKey] = {0, 0};
+		buyVal = {inverted?1.0/buy->price:buy->price, buy->size*buyid};
 	}
-
 	if (sell.has_value()) {
-		orderMap[sellKey] = {inverted?1.0/sell->price:sell->price, sell->size*buyid};
-	} else {
-		orderMap[sellKey] = {0, 0};
+		sellVal = {inverted?1.0/sell->price:sell->price, sell->size*buyid};
+	}
+
+	auto differs = [&](const OKey &key, const OValue &val) {
+		auto iter = orderMap.find(key);
+		return iter == orderMap.end() || iter->second.price != val.price || iter->second.size != val.size;
+	};
+	if (differs(buyKey, buyVal) || differs(sellKey, sellVal)) {
+		markChange(orderRev, symb);
+		orderMap[buyKey] = buyVal;
+		orderMap[sellKey] = sellVal;
+		Array ords;
+		for (auto &&ord : {std::make_pair(buyKey, buyVal), std::make_pair(sellKey, sellVal)}) {
+			if (ord.second.size) {
+				ords.push_back(Object
+						("symb",ord.first.symb)
+						("dir",static_cast<int>(ord.first.dir))
+						("size",ord.second.size)
+						("price",ord.second.price));
+			}
+		}
+		sendEvent("orders", Object("symb", symb)("orders", ords));
 	}
 
 
@@ -85,15 +380,34 @@ void Report::setOrders(StrViewA symb, const std::optional<IStockApi::Order> &buy
 
 void Report::setTrades(StrViewA symb, StringView<IStockApi::TradeWithBalance> trades) {
 
-	using ondra_shared::range;
-
-	json::Array records;
-
 	const json::Value &info = infoMap[symb];
 	bool inverted = info["inverted"].getBool();
 	bool margin = false; //TODO TBD
 
+	PLState &st = plMap[symb];
+	std::shared_ptr<TradeIndex> idx;
+	{
+		std::lock_guard<std::mutex> _(tradeIndexLock);
+		auto &i = tradeIndex[symb];
+		if (i == nullptr) i = std::make_shared<TradeIndex>();
+		idx = i;
+	}
+
+	//check, whether the history still starts by the processed trades
+	//otherwise (trade erased, reset, etc) rebuild the state
+	std::size_t count = st.acc.count;
+	bool valid = count < trades.length && st.acc.inverted == inverted;
+	if (valid && count) {
+		const auto &t = trades[count-1];
+		valid = t.id == st.last_id && t.time == st.last_time && t.size == st.last_size;
+	}
+	if (!valid) {
+		st = PLState();
+		st.acc.inverted = inverted;
+		idx->clear();
+	}
 
+	json::Array records;
 
 	if (!trades.empty()) {
 
@@ -101,92 +415,133 @@ void Report::setTrades(StrViewA symb, StringView<IStockApi::TradeWithBalance> tr
 		std::size_t last_time = last.time;
 		std::size_t first = last_time - interval_in_ms;
 
+		//calculator's balances of all new trades at once
+		std::size_t from = st.acc.count;
+		const double *calcbal = calcTradeBalances(trades, from);
+
+		//advance over new trades, except the last one
+		while (st.acc.count+1 < trades.length) {
+			const auto &t = trades[st.acc.count];
+			st.records.push_back(advanceTrade(st.acc, t, margin, calcbal[st.acc.count-from]));
+			idx->push(TradeIndex::Entry::fromRecord(st.records.back()));
+			st.last_id = t.id;
+			st.last_time = t.time;
+			st.last_size = t.size;
+		}
+		while (!st.records.empty() && st.records.front()["time"].getUInt() < first) {
+			st.records.pop_front();
+		}
 
-		auto tend = trades.end();
-		auto iter = trades.begin();
-		auto &&t = *iter;
-
-		std::size_t invest_beg_time = t.time;
-		double invst_value = t.eff_price*t.balance;
-
-		//so the first trade doesn't change the value of portfolio
-//		double init_value = init_balance*t.eff_price+init_fiat;
-		//
-		double init_price = t.eff_price;
-
-
-		double prev_balance = t.balance-t.eff_size;
-		double prev_price = init_price;
-		double ass_sum = 0;
-		double cur_sum = 0;
-		double cur_fromPos = 0;
-		double norm_sum_ass = 0;
-		double norm_sum_cur = 0;
-
+		//the last trade is processed on a copy of the state
+		PLAcc tmp = st.acc;
+		json::Value lastRec = advanceTrade(tmp, last, margin, calcbal[trades.length-1-from]);
+		idx->setLast(TradeIndex::Entry::fromRecord(lastRec));
 
+		records.reserve(st.records.size()+1);
+		for (auto &&r: st.records) records.push_back(r);
+		records.push_back(lastRec);
+	} else {
+		idx->setLast(std::nullopt);
+	}
+	std::size_t chg = markRecords(symb, records);
+	tradeMap[symb] = records;
+	if (chg != no_change) {
+		sendEvent("trades", Object("symb", symb)("chart", chartChange(records, chg)));
+	}
+}
 
-		while (iter != tend) {
+Report::PTradeIndex Report::getTradeIndex(StrViewA symb) const {
+	std::lock_guard<std::mutex> _(tradeIndexLock);
+	auto iter = tradeIndex.find(symb);
+	if (iter == tradeIndex.end()) return nullptr;
+	else return iter->second;
+}
 
-			auto &&t = *iter;
+const double *Report::calcTradeBalances(StringView<IStockApi::TradeWithBalance> trades, std::size_t from) {
+	std::size_t n = trades.length - from;
+	plBuffer.resize(4*n);
+	double *prev_price = plBuffer.data();
+	double *prev_balance = prev_price+n;
+	double *price = prev_balance+n;
+	double *out = price+n;
+	for (std::size_t i = 0; i < n; i++) {
+		const auto &t = trades[from+i];
+		if (from+i == 0) {
+			//the first trade doesn't change the value of portfolio
+			prev_price[i] = t.eff_price;
+			prev_balance[i] = t.balance-t.eff_size;
+		} else {
+			const auto &p = trades[from+i-1];
+			prev_price[i] = p.eff_price;
+			prev_balance[i] = p.balance;
+		}
+		price[i] = t.eff_price;
+	}
+	//every trade has own calculator - price and balance of the previous trade
+	Calculator::price2balance(Calculator::Batch{prev_price, prev_balance, n}, price, out);
+	return out;
+}
 
-			double gain = (t.eff_price - prev_price)*ass_sum ;
-			double earn = -t.eff_price * t.eff_size;
-			double bal_chng = (t.balance - prev_balance) - t.eff_size;
-			invst_value += bal_chng * t.eff_price;
+json::Value Report::advanceTrade(PLAcc &st, const IStockApi::TradeWithBalance &t, bool margin, double calcbal) {
 
+	bool inverted = st.inverted;
+	bool first_trade = st.count == 0;
 
-			double calcbal = prev_balance * sqrt(prev_price/t.eff_price);
-			double asschg = (prev_balance+t.eff_size) - calcbal ;
-			double curchg = -(calcbal * t.eff_price -  prev_balance * prev_price - earn);
-			double norm_chng = 0;
-			if (iter != trades.begin() && !iter->manual_trade) {
-				cur_fromPos += gain;
-				ass_sum += t.eff_size;
-				cur_sum += earn;
+	if (first_trade) {
+		st.invest_beg_time = t.time;
+		st.invst_value = t.eff_price*t.balance;
+		//so the first trade doesn't change the value of portfolio
+		st.prev_balance = t.balance-t.eff_size;
+		st.prev_price = t.eff_price;
+	}
 
-				norm_sum_ass += asschg;
-				norm_sum_cur += curchg;
-				norm_chng = curchg+asschg * t.eff_price;
-			}
-			if (iter->manual_trade) {
-				invst_value += earn;
-			}
-			double norm = norm_sum_cur+(margin?norm_sum_ass:0)*t.eff_price;
-
-
-			prev_balance = t.balance;
-			prev_price = t.eff_price;
-
-			double invst_time = t.time - invest_beg_time;
-			double invst_n = norm/invst_time;
-			if (!std::isfinite(invst_n)) invst_n = 0;
-
-
-			if (t.time >= first) {
-				records.push_back(Object
-						("id", t.id)
-						("time", t.time)
-						("achg", (inverted?-1:1)*t.eff_size)
-						("gain", gain)
-						("norm", norm)
-						("normch", norm_chng)
-						("nacum", (inverted?-1:1)*norm_sum_ass)
-						("pos", (inverted?-1:1)*ass_sum)
-						("pl", cur_fromPos)
-						("price", (inverted?1.0/t.price:t.price))
-						("invst_v", invst_value)
-						("invst_n", invst_n)
-						("volume", (inverted?1:-1)*t.eff_price*t.eff_size)
-						("man",t.manual_trade)
-				);
-			}
+	double gain = (t.eff_price - st.prev_price)*st.ass_sum ;
+	double earn = -t.eff_price * t.eff_size;
+	double bal_chng = (t.balance - st.prev_balance) - t.eff_size;
+	st.invst_value += bal_chng * t.eff_price;
 
 
-			++iter;
-		}
+	double asschg = (st.prev_balance+t.eff_size) - calcbal ;
+	double curchg = -(calcbal * t.eff_price -  st.prev_balance * st.prev_price - earn);
+	double norm_chng = 0;
+	if (!first_trade && !t.manual_trade) {
+		st.cur_fromPos += gain;
+		st.ass_sum += t.eff_size;
+		st.cur_sum += earn;
 
+		st.norm_sum_ass += asschg;
+		st.norm_sum_cur += curchg;
+		norm_chng = curchg+asschg * t.eff_price;
 	}
-	tradeMap[symb] = records;
+	if (t.manual_trade) {
+		st.invst_value += earn;
+	}
+	double norm = st.norm_sum_cur+(margin?st.norm_sum_ass:0)*t.eff_price;
+
+
+	st.prev_balance = t.balance;
+	st.prev_price = t.eff_price;
+	st.count++;
+
+	double invst_time = t.time - st.invest_beg_time;
+	double invst_n = norm/invst_time;
+	if (!std::isfinite(invst_n)) invst_n = 0;
+
+	return Object
+			("id", t.id)
+			("time", t.time)
+			("achg", (inverted?-1:1)*t.eff_size)
+			("gain", gain)
+			("norm", norm)
+			("normch", norm_chng)
+			("nacum", (inverted?-1:1)*st.norm_sum_ass)
+			("pos", (inverted?-1:1)*st.ass_sum)
+			("pl", st.cur_fromPos)
+			("price", (inverted?1.0/t.price:t.price))
+			("invst_v", st.invst_value)
+			("invst_n", invst_n)
+			("volume", (inverted?1:-1)*t.eff_price*t.eff_size)
+			("man",t.manual_trade);
 }
 
 
@@ -207,13 +562,19 @@ bool Report::OKeyCmp::operator ()(const OKey& a, const OKey& b) const {
 }
 
 void Report::setInfo(StrViewA symb, const InfoObj &infoObj) {
-	infoMap[symb] = Object
+	json::Value info = Object
 			("title",infoObj.title)
 			("currency", infoObj.currencySymb)
 			("asset", infoObj.assetSymb)
 			("price_symb", infoObj.priceSymb)
 			("inverted", infoObj.inverted)
 			("emulated",infoObj.emulated);
+	json::Value &cur = infoMap[symb];
+	if (cur != info) {
+		cur = info;
+		markChange(infoRev, symb);
+		sendEvent("info", Object("symb", symb)("info", info));
+	}
 }
 
 void Report::setPrice(StrViewA symb, double price) {
@@ -221,7 +582,13 @@ void Report::setPrice(StrViewA symb, double price) {
 	const json::Value &info = infoMap[symb];
 	bool inverted = info["inverted"].getBool();
 
-	priceMap[symb] = inverted?1.0/price:price;;
+	double p = inverted?1.0/price:price;
+	double &cur = priceMap[symb];
+	if (cur != p) {
+		cur = p;
+		markChange(priceRev, symb);
+		sendEvent("price", Object("symb", symb)("price", p));
+	}
 }
 
 
@@ -256,7 +623,12 @@ void Report::setError(StrViewA symb, const ErrorObj &errorObj) {
 	if (!errorObj.genError.empty()) obj.set("gen", errorObj.genError);
 	if (!errorObj.buyError.empty()) obj.set("buy", errorObj.buyError);
 	if (!errorObj.sellError.empty()) obj.set("sell", errorObj.sellError);
-	errorMap[symb] = obj;
+	json::Value &cur = errorMap[symb];
+	if (cur != json::Value(obj)) {
+		cur = obj;
+		markChange(miscRev, symb);
+		sendMiscEvent(symb);
+	}
 }
 
 void Report::exportMisc(json::Object &&out) {
@@ -268,7 +640,63 @@ void Report::exportMisc(json::Object &&out) {
 }
 
 void Report::addLogLine(StrViewA ln) {
-	logLines.push_back(ln);
+	std::uint64_t seq = logRing.push(ln);
+	if (streamCount.load(std::memory_order_relaxed)) sendEvent("log", Object("seq", seq)("line", ln));
+}
+
+json::Value Report::exportLog() const {
+	Array out;
+	for (auto &&ln: logRing.read(0, logLinesInReport)) out.push_back(ln.text);
+	return out;
+}
+
+std::vector<LogRing::Line> Report::getLog(std::uint64_t since) const {
+	return logRing.read(since);
+}
+
+void Report::sendMiscEvent(StrViewA symb) {
+	auto iter = miscMap.find(symb);
+	if (iter == miscMap.end()) return;
+	auto erritr = errorMap.find(symb);
+	Value err = erritr == errorMap.end()?Value():erritr->second;
+	sendEvent("misc", Object("symb", symb)("misc", iter->second.replace("error", err)));
+}
+
+bool Report::addStream(PEventQueue q) {
+	std::lock_guard<std::mutex> _(streamLock);
+	//queues closed by their writers are otherwise removed by the next event
+	auto iter = std::remove_if(streams.begin(), streams.end(), [](const PEventQueue &q) {
+		return q->isClosed();
+	});
+	streams.erase(iter, streams.end());
+	bool ok = streams.size() < maxStreams;
+	if (ok) streams.push_back(std::move(q));
+	streamCount.store(streams.size(), std::memory_order_relaxed);
+	return ok;
+}
+
+void Report::closeStreams() {
+	std::lock_guard<std::mutex> _(streamLock);
+	for (auto &&q: streams) q->close();
+	streams.clear();
+	streamCount.store(0, std::memory_order_relaxed);
+}
+
+void Report::sendEvent(const char *event, json::Value data) {
+	//the lock is held only to push the message to the queues, no I/O is made here
+	std::lock_guard<std::mutex> _(streamLock);
+	if (streams.empty()) return;
+	std::string msg("event: ");
+	msg.append(event);
+	msg.append("\ndata: ");
+	msg.append(data.stringify().str());
+	msg.append("\n\n");
+	auto pmsg = std::make_shared<const std::string>(std::move(msg));
+	auto iter = std::remove_if(streams.begin(), streams.end(), [&](const PEventQueue &q) {
+		return !q->push(pmsg);
+	});
+	streams.erase(iter, streams.end());
+	streamCount.store(streams.size(), std::memory_order_relaxed);
 }
 
 using namespace ondra_shared;
@@ -312,9 +740,10 @@ void Report::setMisc(StrViewA symb, const MiscData &miscData) {
 	}
 
 
+	json::Value misc;
 	if (inverted) {
 
-		miscMap[symb] = Object
+		misc = Object
 				("t",-miscData.trade_dir)
 				("a", miscData.achieve)
 				("mcp", fixNum(1.0/miscData.calc_price))
@@ -327,7 +756,7 @@ void Report::setMisc(StrViewA symb, const MiscData &miscData) {
 				("mh",fixNum(1.0/miscData.lowest_price))
 				("mt",miscData.total_trades);
 	} else {
-		miscMap[symb] = Object
+		misc = Object
 				("t",miscData.trade_dir)
 				("a", miscData.achieve)
 				("mcp", fixNum(miscData.calc_price))
@@ -340,4 +769,10 @@ void Report::setMisc(StrViewA symb, const MiscData &miscData) {
 				("mh",fixNum(miscData.highest_price))
 				("mt",miscData.total_trades);
 	}
+	json::Value &cur = miscMap[symb];
+	if (cur != misc) {
+		cur = misc;
+		markChange(miscRev, symb);
+		sendMiscEvent(symb);
+	}
 }
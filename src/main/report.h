@@ -9,9 +9,19 @@
 #define SRC_MAIN_REPORT_H_
 
 #include <imtjson/array.h>
+#include <atomic>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
+#include "event_queue.h"
 #include "istockapi.h"
+#include "log_ring.h"
 #include "storage.h"
+#include "trade_index.h"
 #include "../shared/linear_map.h"
 #include "../shared/stdLogOutput.h"
 #include "../shared/stringview.h"
@@ -30,12 +40,93 @@ public:
 	using ErrorObj = IStatSvc::ErrorObj;
 	using InfoObj = IStatSvc::Info;
 
-	Report(StoragePtr &&report, std::size_t interval_in_ms, bool a2np )
-		:report(std::move(report)),interval_in_ms(interval_in_ms),a2np(a2np) {}
+	Report(StoragePtr &&report, StoragePtr &&delta, std::size_t interval_in_ms, bool a2np )
+		:report(std::move(report)),delta(std::move(delta)),interval_in_ms(interval_in_ms),a2np(a2np)
+		,etagPrefix(std::to_string(std::time(nullptr))+"-") {}
+	///Closes the event streams, so their writers don't outlive the report
+	~Report() {closeStreams();}
 
 
 	void genReport();
 
+	///Generates delta report
+	/**
+	 * @param since revision known to the client
+	 * @return object which contains only sections and records changed after the revision.
+	 */
+	json::Value genDelta(std::size_t since) const;
+
+	///Returns current revision
+	std::size_t getRevision() const {return revision;}
+
+	///Serialized report prepared for delivery through the HTTP
+	struct Published {
+		std::size_t rev;
+		std::string etag;
+		std::string content;
+		///content compressed by gzip
+		std::string gzip;
+	};
+
+	using PPublished = std::shared_ptr<const Published>;
+
+	///Enables publishing for the HTTP server
+	/** When enabled, the genReport() also serializes and compresses the report and
+	 * the delta and keeps them in the memory
+	 */
+	void enablePublish(bool enable) {publish_enabled = enable;}
+	///Returns last generated report - thread safe
+	PPublished getPublishedReport() const;
+	///Returns last generated delta report - thread safe
+	PPublished getPublishedDelta() const;
+
+	///Registers new event stream
+	/**
+	 * The stream receives events: price, orders, info, misc, trades (changed records), log
+	 * and rev (once the report is generated). Events are only pushed to the queue,
+	 * the caller is responsible to drain the queue and to write events to the client.
+	 * The stream is removed once its queue is closed (or becomes full)
+	 *
+	 * @retval true registered
+	 * @retval false too many streams (see maxStreams), the queue was not registered
+	 */
+	bool addStream(PEventQueue q);
+
+	///Closes queues of all streams - their writers finish
+	void closeStreams();
+
+	///Maximum count of concurrently opened streams
+	static constexpr std::size_t maxStreams = 32;
+
+	///Enables sharded report
+	/**
+	 * Sharded report consists of one file per trader (shard_<symb>.json) and
+	 * the index file (report_index.json), which contains the revision of each shard, the log
+	 * and the common fields. Only shards changed since the last generation are rebuilt.
+	 *
+	 * @param files storage factory used to write shards to files. Can be empty, then
+	 * shards are only published for the HTTP server (if publishing is enabled)
+	 */
+	void enableShards(std::optional<StorageFactory> &&files);
+	///Returns published shard index - thread safe
+	PPublished getPublishedIndex() const;
+	///Returns published shard - thread safe
+	/**
+	 * @param name name of the shard file
+	 * @return shard, or nullptr if not found
+	 */
+	PPublished getPublishedShard(const std::string &name) const;
+	///Returns name of the shard file for given symbol
+	static std::string shardName(StrViewA symb);
+
+	using PTradeIndex = std::shared_ptr<const TradeIndex>;
+	///Returns index of all trades of the trader - thread safe
+	/**
+	 * @param symb trader's symbol
+	 * @return index, or nullptr if trader is not known
+	 */
+	PTradeIndex getTradeIndex(StrViewA symb) const;
+
 	using StrViewA = ondra_shared::StrViewA;
 	template<typename T> using StringView = ondra_shared::StringView<T>;
 	void setOrders(StrViewA symb, const std::optional<IStockApi::Order> &buy,
@@ -45,7 +136,14 @@ public:
 	void setMisc(StrViewA symb, const MiscData &miscData);
 
 	void setPrice(StrViewA symb, double price);
+	///Adds line to the log - thread safe
+	/** The line is written to the lock-free ring. Only when an event stream is opened,
+	 * the line is also sent to the streams, which takes the stream lock */
 	void addLogLine(StrViewA ln);
+	///Returns log lines written after given sequence number - thread safe
+	std::vector<LogRing::Line> getLog(std::uint64_t since) const;
+	///Returns sequence number of the last log line - thread safe
+	std::uint64_t getLogSeq() const {return logRing.lastSeq();}
 
 	virtual void setError(StrViewA symb, const ErrorObj &errorObj);
 
@@ -74,6 +172,39 @@ protected:
 	using InfoMap = ondra_shared::linear_map<std::string, json::Value>;
 	using MiscMap = ondra_shared::linear_map<std::string, json::Value>;
 	using PriceMap = ondra_shared::linear_map<std::string, double>;
+	using RevMap = ondra_shared::linear_map<std::string, std::size_t>;
+
+	///Running accumulators of the trade statistics
+	struct PLAcc {
+		///count of trades processed
+		std::size_t count = 0;
+		bool inverted = false;
+		std::size_t invest_beg_time = 0;
+		double invst_value = 0;
+		double prev_balance = 0;
+		double prev_price = 0;
+		double ass_sum = 0;
+		double cur_sum = 0;
+		double cur_fromPos = 0;
+		double norm_sum_ass = 0;
+		double norm_sum_cur = 0;
+	};
+
+	///Statistics of the trader
+	/** The state covers all trades except the last one, because the last trade
+	 * can be still merged with a next trade. */
+	struct PLState {
+		PLAcc acc;
+		///identification of the last processed trade
+		json::Value last_id;
+		std::uint64_t last_time = 0;
+		double last_size = 0;
+		///records of processed trades inside of the interval
+		std::deque<json::Value> records;
+	};
+	using PLMap = ondra_shared::linear_map<std::string, PLState>;
+	using TradeIndexMap = ondra_shared::linear_map<std::string, std::shared_ptr<TradeIndex> >;
+	using RecRevMap = ondra_shared::linear_map<std::string, std::vector<std::size_t> >;
 
 	OrderMap orderMap;
 	TradeMap tradeMap;
@@ -81,9 +212,71 @@ protected:
 	PriceMap priceMap;
 	MiscMap miscMap;
 	MiscMap errorMap;
-	json::Array logLines;
+	PLMap plMap;
+	TradeIndexMap tradeIndex;
+	mutable std::mutex tradeIndexLock;
+	LogRing logRing;
+	///count of log lines in the report
+	static constexpr std::size_t logLinesInReport = 30;
+	json::Value exportLog() const;
+
+	///revision of the next report - all changes are marked by this number
+	std::size_t revision = 1;
+	///revisions of the last change of each section, per symbol
+	RevMap chartRev, orderRev, infoRev, priceRev, miscRev;
+	///revisions of each trade record
+	RecRevMap recordRev;
+	///count of revisions kept in the delta file
+	static constexpr std::size_t deltaDepth = 10;
 
 	StoragePtr report;
+	StoragePtr delta;
+
+	bool publish_enabled = false;
+	mutable std::mutex pubLock;
+	PPublished pubReport, pubDelta;
+	PPublished publish(json::Value data) const;
+
+	bool shards_enabled = false;
+	std::optional<StorageFactory> shardFiles;
+	StoragePtr shardIndex;
+	ondra_shared::linear_map<std::string, StoragePtr> shardStorage;
+	///revision of the each shard when it was generated
+	RevMap shardGen;
+	PPublished pubIndex;
+	ondra_shared::linear_map<std::string, PPublished> pubShards;
+
+	void genShards();
+	json::Value genShard(const std::string &symb, std::size_t rev) const;
+	std::size_t shardRevision(const std::string &symb) const;
+
+	void markChange(RevMap &map, StrViewA symb);
+	static constexpr std::size_t no_change = static_cast<std::size_t>(-1);
+	///Marks changed records
+	/** @return position of the first changed record, or no_change */
+	std::size_t markRecords(StrViewA symb, json::Value records);
+	static json::Value chartChange(json::Value records, std::size_t pos);
+
+	std::mutex streamLock;
+	std::vector<PEventQueue> streams;
+	///count of streams - it is checked without the lock before an event is formatted
+	std::atomic<std::size_t> streamCount{0};
+	void sendEvent(const char *event, json::Value data);
+	void sendMiscEvent(StrViewA symb);
+	///Advances the P&L state by the trade
+	/**
+	 * @param calcbal balance of the calculator after the previous trade at the price of
+	 * this trade (see calcTradeBalances())
+	 */
+	static json::Value advanceTrade(PLAcc &st, const IStockApi::TradeWithBalance &t, bool margin, double calcbal);
+	///Calculates the calculator's balance of every trade from given position by single batch
+	/**
+	 * @return array of balances, item 0 belongs to the trade at position 'from'. The array
+	 * is valid until the next call
+	 */
+	const double *calcTradeBalances(StringView<IStockApi::TradeWithBalance> trades, std::size_t from);
+	///buffer of calcTradeBalances()
+	std::vector<double> plBuffer;
 
 
 	void exportCharts(json::Object&& out);
@@ -93,6 +286,7 @@ protected:
 	void exportMisc(json::Object &&out);
 	std::size_t interval_in_ms;
 	bool a2np;
+	std::string etagPrefix;
 };
 
 
@@ -0,0 +1,73 @@
+/*
+ * shared_feed.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "shared_feed.h"
+
+template<typename T, typename Fn>
+const T &SharedFeedApi::cached(Cache<T> &cache, const std::string_view &key, Fn &&fn) {
+	auto iter = cache.find(key);
+	if (iter == cache.end()) {
+		iter = cache.emplace(std::string(key), fn()).first;
+	}
+	return iter->second;
+}
+
+double SharedFeedApi::getBalance(const std::string_view &symb) {
+	return cached(balances, symb, [&]{return datasrc.getBalance(symb);});
+}
+
+IStockApi::TradeHistory SharedFeedApi::getTrades(json::Value, std::uintptr_t, const std::string_view &) {
+	return TradeHistory();
+}
+
+IStockApi::Orders SharedFeedApi::getOpenOrders(const std::string_view &) {
+	return Orders();
+}
+
+IStockApi::Ticker SharedFeedApi::getTicker(const std::string_view &pair) {
+	return cached(tickers, pair, [&]{return datasrc.getTicker(pair);});
+}
+
+json::Value SharedFeedApi::placeOrder(const std::string_view &, double, double, json::Value, json::Value, double) {
+	throw std::runtime_error("Shared feed: shadow trader can't place orders");
+}
+
+std::vector<IStockApi::OrderResult> SharedFeedApi::placeOrders(const std::vector<OrderRequest> &orders) {
+	//the batch is never passed to the broker, all orders are rejected at once
+	return std::vector<OrderResult>(orders.size(), OrderResult{json::Value(), "Shared feed: shadow trader can't place orders"});
+}
+
+IStockApi::MarketInfo SharedFeedApi::getMarketInfo(const std::string_view &pair) {
+	return cached(minfos, pair, [&]{return datasrc.getMarketInfo(pair);});
+}
+
+double SharedFeedApi::getFees(const std::string_view &pair) {
+	return cached(fees, pair, [&]{return datasrc.getFees(pair);});
+}
+
+void SharedFeedApi::newCycle() {
+	tickers.clear();
+	fees.clear();
+	balances.clear();
+}
+
+IStockApi *SharedFeedSelector::getStock(const std::string_view &stockName) const {
+	auto iter = feeds.find(stockName);
+	if (iter == feeds.end()) {
+		IStockApi *s = source.getStock(stockName);
+		if (s == nullptr) return nullptr;
+		iter = feeds.emplace(std::string(stockName), std::make_unique<SharedFeedApi>(*s)).first;
+	}
+	return iter->second.get();
+}
+
+void SharedFeedSelector::forEachStock(EnumFn fn) const {
+	for (auto &&x: feeds) fn(x.first, *x.second);
+}
+
+void SharedFeedSelector::newCycle() {
+	for (auto &&x: feeds) x.second->newCycle();
+}
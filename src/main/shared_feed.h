@@ -0,0 +1,86 @@
+/*
+ * shared_feed.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_SHARED_FEED_H_
+#define SRC_MAIN_SHARED_FEED_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "istockapi.h"
+
+///Read-only market feed shared by the shadow traders
+/**
+ * The feed caches the ticker, the fees and the balances of the broker until the
+ * next trading cycle (see newCycle()), so any count of shadow traders on the same
+ * pair causes only one request to the broker per cycle. Market info is cached
+ * forever.
+ *
+ * The feed never places orders and reports no trades or open orders. It is always
+ * wrapped by the EmulatorAPI, which emulates orders of each shadow trader.
+ */
+class SharedFeedApi: public IStockApi {
+public:
+
+	explicit SharedFeedApi(IStockApi &datasrc):datasrc(datasrc) {}
+
+	virtual double getBalance(const std::string_view & symb) override;
+	virtual TradeHistory getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view & pair) override;
+	virtual Orders getOpenOrders(const std::string_view & par) override;
+	virtual Ticker getTicker(const std::string_view & piar) override;
+	virtual json::Value placeOrder(const std::string_view & pair,
+			double size, double price,json::Value clientId,
+			json::Value replaceId,double replaceSize) override;
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders) override;
+	virtual bool reset() override {return true;}
+	virtual bool isTest() const override {return datasrc.isTest();}
+	virtual MarketInfo getMarketInfo(const std::string_view & pair) override;
+	virtual double getFees(const std::string_view &pair) override;
+	virtual std::vector<std::string> getAllPairs() override {return datasrc.getAllPairs();}
+	virtual void testBroker() override {datasrc.testBroker();}
+
+	///Invalidates cached values, call once at the beginning of every trading cycle
+	void newCycle();
+
+protected:
+	IStockApi &datasrc;
+
+	template<typename T> using Cache = std::map<std::string, T, std::less<> >;
+
+	Cache<Ticker> tickers;
+	Cache<double> fees;
+	Cache<double> balances;
+	Cache<MarketInfo> minfos;
+
+	template<typename T, typename Fn>
+	static const T &cached(Cache<T> &cache, const std::string_view &key, Fn &&fn);
+};
+
+///Selects shared feeds for the shadow traders
+/**
+ * Feeds are created on the first request and wrap the brokers of the source selector.
+ * The selector must be cleared before the source selector is cleared.
+ */
+class SharedFeedSelector: public IStockSelector {
+public:
+
+	explicit SharedFeedSelector(const IStockSelector &source):source(source) {}
+
+	virtual IStockApi *getStock(const std::string_view &stockName) const override;
+	virtual void forEachStock(EnumFn fn) const override;
+
+	///Invalidates cached values of all feeds
+	void newCycle();
+	void clear() {feeds.clear();}
+
+protected:
+	const IStockSelector &source;
+	mutable std::map<std::string, std::unique_ptr<SharedFeedApi>, std::less<> > feeds;
+};
+
+
+#endif /* SRC_MAIN_SHARED_FEED_H_ */
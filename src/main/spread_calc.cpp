@@ -8,6 +8,7 @@
 
 #include "spread_calc.h"
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 
@@ -57,7 +58,7 @@ struct EmulResult {
 	int trades;
 };
 
-static EmulResult emulateMarket(ondra_shared::StringView<IStatSvc::ChartItem> chart,
+static EmulResult emulateMarket(const ChartSoA::View &chart,
 		const MTrader_Config &config,
 		const IStockApi::MarketInfo &minfo,
 		double balance,
@@ -69,6 +70,9 @@ static EmulResult emulateMarket(ondra_shared::StringView<IStatSvc::ChartItem> ch
 	MTrader_Config cfg(config);
 	cfg.dry_run = false;
 	cfg.spread_calc_mins=1;
+	//EmulStatSvc ignores the chart, so don't build the tiers
+	cfg.spread_calc_tier = 1;
+	cfg.chart_history_days = 0;
 	cfg.internal_balance = false;
 	cfg.dynmult_fall = 100;
 	cfg.dynmult_raise = 0;
@@ -111,6 +115,11 @@ static EmulResult emulateMarket(ondra_shared::StringView<IStatSvc::ChartItem> ch
 	double score = emul.getScore()-initScore;
 	std::intptr_t tcount = emul.getTradeCount();
 	if (tcount == 0) return EmulResult{-1001,0};
+	//the chart can be downsampled - count minutes, not steps
+	if (chart.length > 1) {
+		std::uintptr_t res = (chart.time[chart.length-1] - chart.time[0])/(60000*(chart.length-1));
+		if (res > 1) counter *= res;
+	}
 	std::intptr_t min_count = std::max<std::intptr_t>(counter*cfg.spread_calc_min_trades/1440,1);
 	std::intptr_t max_count = (counter*cfg.spread_calc_max_trades+1439)/1440;
 	if (tcount < min_count) score = tcount-min_count;
@@ -123,12 +132,12 @@ static EmulResult emulateMarket(ondra_shared::StringView<IStatSvc::ChartItem> ch
 
 
 
-std::pair<double,double> glob_calcSpread2(ondra_shared::StringView<IStatSvc::ChartItem> chart,
+static std::pair<double,double> glob_calcSpread2(const ChartSoA::View &chart,
 		const MTrader_Config &config,
 		const IStockApi::MarketInfo &minfo,
 		double balance,
 		double prev_val) {
-	double curprice = sqrt(chart[chart.length-1].ask*chart[chart.length-1].bid);
+	double curprice = chart.mid[chart.length-1];
 
 
 	using ResultItem = std::pair<double,double>;
@@ -175,11 +184,17 @@ double glob_calcSpread(ondra_shared::StringView<IStatSvc::ChartItem> chart,
 		double prev_val) {
 	if (prev_val < 1e-10) prev_val = 0.01;
 	if (chart.empty() || balance == 0) return prev_val;
-	double curprice = sqrt(chart[chart.length-1].ask*chart[chart.length-1].bid);
-	auto sp1 = glob_calcSpread2(chart, config, minfo, balance, prev_val);
+	//split the chart once, all emulations share it
+	ChartSoA soa(chart);
+	ChartSoA::View view = soa.view();
+	double curprice = view.mid[view.length-1];
+	auto sp1 = glob_calcSpread2(view, config, minfo, balance, prev_val);
 	auto sp2 = sp1;
-	if (chart.length > 1000) {
-		 sp2 = glob_calcSpread2(chart.substr(chart.length-1000), config, minfo, balance, prev_val);
+	//short window - last 1000 minutes, the chart can have any resolution (see chart tiers)
+	std::uintptr_t short_begin = view.time[view.length-1] - std::min<std::uintptr_t>(view.time[view.length-1], 1000*60000);
+	std::size_t short_pos = static_cast<std::size_t>(std::lower_bound(view.time, view.time+view.length, short_begin) - view.time);
+	if (short_pos > 0) {
+		 sp2 = glob_calcSpread2(view.substr(short_pos), config, minfo, balance, prev_val);
 	}
 	double sp3 = (sp1.first + sp2.first)/2.0;
 	logInfo("Spread calculated: long=$1 (profit=$2), short=$3 (profit=$4), final=$5",curprice*(exp(sp1.first)-1),
@@ -0,0 +1,295 @@
+/*
+ * stock_recorder.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "stock_recorder.h"
+
+#include <imtjson/array.h>
+#include <imtjson/binjson.tcc>
+#include <imtjson/object.h>
+
+using json::Value;
+
+RecordingStockApi::RecordingStockApi(IStockApi &target, std::unique_ptr<IStockApi> &&owned, const std::string &fname)
+	:target(target),owned(std::move(owned)),out(fname, std::ios::out|std::ios::trunc|std::ios::binary) {
+	if (!out) throw std::runtime_error("Can't open the record file: "+fname);
+	record(Value(json::array,{"init", json::Object("test", target.isTest())}));
+}
+
+void RecordingStockApi::record(json::Value rec) {
+	std::lock_guard<std::mutex> _(lock);
+	rec.serializeBinary([&](char c) {out.put(c);},json::compressKeys);
+	out.flush();
+}
+
+template<typename Fn, typename ToJSON>
+auto RecordingStockApi::call(const char *method, json::Value args, Fn &&fn, ToJSON &&toJSON) -> decltype(fn()) {
+	try {
+		auto res = fn();
+		record(Value(json::array,{method, args, toJSON(res)}));
+		return res;
+	} catch (std::exception &e) {
+		record(Value(json::array,{method, args, nullptr, e.what()}));
+		throw;
+	}
+}
+
+static Value identity(Value v) {return v;}
+
+double RecordingStockApi::getBalance(const std::string_view &symb) {
+	return call("getBalance", json::StrViewA(symb), [&]{
+		return target.getBalance(symb);
+	}, [](double v){return Value(v);});
+}
+
+IStockApi::TradeHistory RecordingStockApi::getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view &pair) {
+	return call("getTrades", json::Object("lastId", lastId)("fromTime", fromTime), [&]{
+		return target.getTrades(lastId, fromTime, pair);
+	}, [](const TradeHistory &th){
+		json::Array res;
+		res.reserve(th.size());
+		for (auto &&t: th) res.push_back(t.toJSON());
+		return Value(res);
+	});
+}
+
+IStockApi::Orders RecordingStockApi::getOpenOrders(const std::string_view &pair) {
+	return call("getOpenOrders", Value(), [&]{
+		return target.getOpenOrders(pair);
+	}, [](const Orders &ords){
+		json::Array res;
+		res.reserve(ords.size());
+		for (auto &&o: ords) res.push_back(o.toJSON());
+		return Value(res);
+	});
+}
+
+IStockApi::Ticker RecordingStockApi::getTicker(const std::string_view &pair) {
+	return call("getTicker", Value(), [&]{
+		return target.getTicker(pair);
+	}, tickerToJSON);
+}
+
+json::Value RecordingStockApi::placeOrder(const std::string_view &pair,
+		double size, double price, json::Value clientId,
+		json::Value replaceId, double replaceSize) {
+	return call("placeOrder", json::Object
+				("size", size)
+				("price", price)
+				("clientId", clientId)
+				("replaceId", replaceId)
+				("replaceSize", replaceSize), [&]{
+		return target.placeOrder(pair, size, price, clientId, replaceId, replaceSize);
+	}, identity);
+}
+
+std::vector<IStockApi::OrderResult> RecordingStockApi::placeOrders(const std::vector<OrderRequest> &orders) {
+	json::Array args;
+	args.reserve(orders.size());
+	for (auto &&o: orders) {
+		args.push_back(json::Object
+				("size", o.size)
+				("price", o.price)
+				("clientId", o.clientId)
+				("replaceId", o.replaceId)
+				("replaceSize", o.replaceSize));
+	}
+	return call("placeOrders", args, [&]{
+		return target.placeOrders(orders);
+	}, orderResultsToJSON);
+}
+
+bool RecordingStockApi::reset() {
+	return call("reset", Value(), [&]{
+		return target.reset();
+	}, [](bool v){return Value(v);});
+}
+
+IStockApi::MarketInfo RecordingStockApi::getMarketInfo(const std::string_view &pair) {
+	return call("getMarketInfo", Value(), [&]{
+		return target.getMarketInfo(pair);
+	}, minfoToJSON);
+}
+
+double RecordingStockApi::getFees(const std::string_view &pair) {
+	return call("getFees", Value(), [&]{
+		return target.getFees(pair);
+	}, [](double v){return Value(v);});
+}
+
+std::vector<std::string> RecordingStockApi::getAllPairs() {
+	return call("getAllPairs", Value(), [&]{
+		return target.getAllPairs();
+	}, [](const std::vector<std::string> &pairs){
+		json::Array res;
+		for (auto &&p: pairs) res.push_back(p);
+		return Value(res);
+	});
+}
+
+void RecordingStockApi::recordState(json::Value state) {
+	record(Value(json::array,{"state", state}));
+}
+
+void RecordingStockApi::recordCycle() {
+	record(Value(json::array,{"cycle"}));
+}
+
+json::Value RecordingStockApi::tickerToJSON(const Ticker &tk) {
+	return json::Object
+			("bid", tk.bid)
+			("ask", tk.ask)
+			("last", tk.last)
+			("time", tk.time);
+}
+
+IStockApi::Ticker RecordingStockApi::tickerFromJSON(json::Value v) {
+	return Ticker {
+		v["bid"].getNumber(),
+		v["ask"].getNumber(),
+		v["last"].getNumber(),
+		v["time"].getUInt()
+	};
+}
+
+json::Value RecordingStockApi::minfoToJSON(const MarketInfo &minfo) {
+	return json::Object
+			("asset_step", minfo.asset_step)
+			("currency_step", minfo.currency_step)
+			("asset_symbol", minfo.asset_symbol)
+			("currency_symbol", minfo.currency_symbol)
+			("min_size", minfo.min_size)
+			("min_volume", minfo.min_volume)
+			("fees", minfo.fees)
+			("feeScheme", strFeeScheme[minfo.feeScheme])
+			("leverage", minfo.leverage)
+			("invert_price", minfo.invert_price)
+			("inverted_symbol", minfo.inverted_symbol);
+}
+
+IStockApi::MarketInfo RecordingStockApi::minfoFromJSON(json::Value v) {
+	MarketInfo res;
+	res.asset_step = v["asset_step"].getNumber();
+	res.currency_step = v["currency_step"].getNumber();
+	res.asset_symbol = v["asset_symbol"].getString();
+	res.currency_symbol = v["currency_symbol"].getString();
+	res.min_size = v["min_size"].getNumber();
+	res.min_volume= v["min_volume"].getNumber();
+	res.fees = v["fees"].getNumber();
+	res.feeScheme = strFeeScheme[v["feeScheme"].getString()];
+	res.leverage= v["leverage"].getNumber();
+	res.invert_price= v["invert_price"].getBool();
+	res.inverted_symbol= v["inverted_symbol"].getString();
+	return res;
+}
+
+json::Value RecordingStockApi::orderResultsToJSON(const std::vector<OrderResult> &res) {
+	json::Array out;
+	out.reserve(res.size());
+	for (auto &&r: res) {
+		if (r.error.empty()) out.push_back(json::Object("id", r.id));
+		else out.push_back(json::Object("error", r.error));
+	}
+	return out;
+}
+
+std::vector<IStockApi::OrderResult> RecordingStockApi::orderResultsFromJSON(json::Value v) {
+	std::vector<OrderResult> res;
+	res.reserve(v.size());
+	for (Value r: v) {
+		res.push_back(OrderResult{r["id"], r["error"].getString()});
+	}
+	return res;
+}
+
+ReplayStockApi::ReplayStockApi(const std::string &fname) {
+	std::ifstream in(fname, std::ios::in|std::ios::binary);
+	if (!in) throw std::runtime_error("Can't open the record file: "+fname);
+	while (in.peek() != EOF) {
+		records.push_back(Value::parseBinary([&] {
+			int i = in.get();
+			if (i == -1) throw std::runtime_error("Unexpected end of the record file: "+fname);
+			return i;
+		}, json::base64));
+	}
+	for (auto &&r: records) {
+		if (r[0].getString() == "init") test = r[1]["test"].getBool();
+		else if (r[0].getString() == "state") {state = r[1]; break;}
+	}
+}
+
+json::Value ReplayStockApi::next(const char *method) {
+	while (pos < records.size()) {
+		Value r = records[pos];
+		json::StrViewA name = r[0].getString();
+		if (name == "init" || name == "state") {
+			pos++;
+			continue;
+		}
+		if (name == "cycle")
+			throw std::runtime_error(std::string("Replay: unexpected call ")+method+" after the end of the cycle");
+		if (name != json::StrViewA(method))
+			throw std::runtime_error(std::string("Replay: expected call ")+name.data+", but "+method+" was called");
+		pos++;
+		if (r.size() > 3) throw IStockApi::Exception(r[3].getString());
+		return r[2];
+	}
+	throw std::runtime_error("Replay: end of the record");
+}
+
+bool ReplayStockApi::nextCycle() {
+	while (pos < records.size()) {
+		if (records[pos++][0].getString() == "cycle") return true;
+	}
+	return false;
+}
+
+double ReplayStockApi::getBalance(const std::string_view &) {
+	return next("getBalance").getNumber();
+}
+
+IStockApi::TradeHistory ReplayStockApi::getTrades(json::Value , std::uintptr_t , const std::string_view &) {
+	TradeHistory th;
+	for (Value v: next("getTrades")) th.push_back(Trade::fromJSON(v));
+	return th;
+}
+
+IStockApi::Orders ReplayStockApi::getOpenOrders(const std::string_view &) {
+	Orders ords;
+	for (Value v: next("getOpenOrders")) ords.push_back(Order::fromJSON(v));
+	return ords;
+}
+
+IStockApi::Ticker ReplayStockApi::getTicker(const std::string_view &) {
+	return RecordingStockApi::tickerFromJSON(next("getTicker"));
+}
+
+json::Value ReplayStockApi::placeOrder(const std::string_view &,
+		double , double , json::Value ,
+		json::Value , double ) {
+	return next("placeOrder");
+}
+
+std::vector<IStockApi::OrderResult> ReplayStockApi::placeOrders(const std::vector<OrderRequest> &) {
+	return RecordingStockApi::orderResultsFromJSON(next("placeOrders"));
+}
+
+bool ReplayStockApi::reset() {
+	return next("reset").getBool();
+}
+
+IStockApi::MarketInfo ReplayStockApi::getMarketInfo(const std::string_view &) {
+	return RecordingStockApi::minfoFromJSON(next("getMarketInfo"));
+}
+
+double ReplayStockApi::getFees(const std::string_view &) {
+	return next("getFees").getNumber();
+}
+
+std::vector<std::string> ReplayStockApi::getAllPairs() {
+	std::vector<std::string> res;
+	for (Value v: next("getAllPairs")) res.push_back(v.getString());
+	return res;
+}
@@ -0,0 +1,124 @@
+/*
+ * stock_recorder.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_STOCK_RECORDER_H_
+#define SRC_MAIN_STOCK_RECORDER_H_
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "istockapi.h"
+
+///Records all calls of the broker and their results to a binary log
+/**
+ * Every call is stored as binary json array [method, args, result] or
+ * [method, args, null, error] when the call throws an exception. The log can
+ * be replayed by the ReplayStockApi. The batch placeOrders() is recorded as a single
+ * call, it is not split to placeOrder() calls, so the replay sends the same requests.
+ *
+ * The first record contains properties of the broker ["init", {test}]. The trader
+ * also stores its initial state to the log (see recordState())
+ */
+class RecordingStockApi: public IStockApi {
+public:
+
+	///Records calls of the broker
+	/**
+	 * @param target broker
+	 * @param owned optional - owned broker (if the target needs to be destroyed with the recorder)
+	 * @param fname name of the log file. The file is overwritten
+	 */
+	RecordingStockApi(IStockApi &target, std::unique_ptr<IStockApi> &&owned, const std::string &fname);
+
+	virtual double getBalance(const std::string_view & symb) override;
+	virtual TradeHistory getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view & pair) override;
+	virtual Orders getOpenOrders(const std::string_view & par) override;
+	virtual Ticker getTicker(const std::string_view & piar) override;
+	virtual json::Value placeOrder(const std::string_view & pair,
+			double size, double price,json::Value clientId,
+			json::Value replaceId,double replaceSize) override;
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders) override;
+	virtual bool reset() override;
+	virtual bool isTest() const override {return target.isTest();}
+	virtual MarketInfo getMarketInfo(const std::string_view & pair) override;
+	virtual double getFees(const std::string_view &pair) override;
+	virtual std::vector<std::string> getAllPairs() override;
+	virtual void testBroker() override {target.testBroker();}
+
+	///Stores state of the trader, which is used as initial state during replay
+	void recordState(json::Value state);
+	///Marks start of the trading cycle
+	void recordCycle();
+
+	static json::Value tickerToJSON(const Ticker &tk);
+	static Ticker tickerFromJSON(json::Value v);
+	static json::Value minfoToJSON(const MarketInfo &minfo);
+	static MarketInfo minfoFromJSON(json::Value v);
+	static json::Value orderResultsToJSON(const std::vector<OrderResult> &res);
+	static std::vector<OrderResult> orderResultsFromJSON(json::Value v);
+
+protected:
+	IStockApi &target;
+	std::unique_ptr<IStockApi> owned;
+	std::ofstream out;
+	std::mutex lock;
+
+	void record(json::Value rec);
+
+	template<typename Fn, typename ToJSON>
+	auto call(const char *method, json::Value args, Fn &&fn, ToJSON &&toJSON) -> decltype(fn());
+};
+
+///Broker which replays calls recorded by the RecordingStockApi
+/**
+ * Calls must come in the same order as they were recorded. Arguments are
+ * not compared, only names of the methods. Recorded exceptions are thrown
+ * again.
+ */
+class ReplayStockApi: public IStockApi {
+public:
+	explicit ReplayStockApi(const std::string &fname);
+
+	virtual double getBalance(const std::string_view & symb) override;
+	virtual TradeHistory getTrades(json::Value lastId, std::uintptr_t fromTime, const std::string_view & pair) override;
+	virtual Orders getOpenOrders(const std::string_view & par) override;
+	virtual Ticker getTicker(const std::string_view & piar) override;
+	virtual json::Value placeOrder(const std::string_view & pair,
+			double size, double price,json::Value clientId,
+			json::Value replaceId,double replaceSize) override;
+	virtual std::vector<OrderResult> placeOrders(const std::vector<OrderRequest> &orders) override;
+	virtual bool reset() override;
+	virtual bool isTest() const override {return test;}
+	virtual MarketInfo getMarketInfo(const std::string_view & pair) override;
+	virtual double getFees(const std::string_view &pair) override;
+	virtual std::vector<std::string> getAllPairs() override;
+	virtual void testBroker() override {}
+
+	///Returns recorded state of the trader (undefined if not recorded)
+	json::Value getState() const {return state;}
+	///Moves to the next trading cycle
+	/**
+	 * @retval true next cycle is ready
+	 * @retval false end of the log
+	 */
+	bool nextCycle();
+	///Returns count of remaining records
+	std::size_t remain() const {return records.size() - pos;}
+
+protected:
+	std::vector<json::Value> records;
+	std::size_t pos = 0;
+	json::Value state;
+	bool test = false;
+
+	json::Value next(const char *method);
+};
+
+
+
+#endif /* SRC_MAIN_STOCK_RECORDER_H_ */
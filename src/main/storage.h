@@ -36,6 +36,19 @@ protected:
 
 };
 
+///Storage which keeps the data in the memory only
+class MemStorage: public IStorage {
+public:
+
+	explicit MemStorage(json::Value data = json::Value()):data(data) {}
+
+	virtual void store(json::Value data) override {this->data = data;}
+	virtual json::Value load() override {return data;}
+
+protected:
+	json::Value data;
+};
+
 
 class StorageFactory {
 public:
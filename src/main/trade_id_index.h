@@ -0,0 +1,131 @@
+/*
+ * trade_id_index.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_TRADE_ID_INDEX_H_
+#define SRC_MAIN_TRADE_ID_INDEX_H_
+
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <imtjson/value.h>
+#include <imtjson/string.h>
+
+///Index of trade identifiers in a trade history
+/**
+ * Maps hash of the canonical form of the id (its string form) to the position in the
+ * history. The histories grow at the end, so the index is extended incrementally
+ * during the lookup. When the history is changed in the middle, the index must
+ * be truncated (see truncate()) or cleared.
+ *
+ * The found position is always verified by comparing the id. A miss in the index is
+ * trusted, the history is never scanned. A stale index is detected when the history
+ * became shorter, when the last indexed item has a different hash, or when a hit
+ * points to an item with a different hash. Then the index is rebuilt once.
+ *
+ * The index is not thread safe. It is shared by the trader and the brokers.
+ */
+class TradeIdIndex {
+public:
+
+	///Hash of the canonical form of the id
+	static std::size_t hash(std::string_view id) {
+		return std::hash<std::string_view>()(id);
+	}
+	static std::size_t hash(const json::Value &id) {
+		json::String s = id.toString();
+		json::StrViewA v = s.str();
+		return hash(std::string_view(v.data, v.length));
+	}
+
+	///Finds the id in the history
+	/**
+	 * @param c history (must support size() and operator[])
+	 * @param getId function which returns id (json::Value) of an item of the history
+	 * @param id id to find, either json::Value or std::string_view (canonical form)
+	 * @return position of the item, or empty if not found
+	 */
+	template<typename Container, typename GetId, typename Id>
+	std::optional<std::size_t> find(const Container &c, GetId &&getId, const Id &id) {
+		if (c.size() < hashes.size()
+				|| (!hashes.empty() && hash(json::Value(getId(c[hashes.size()-1]))) != hashes.back())) {
+			clear();
+		}
+		update(c, getId);
+		std::size_t h = hash(id);
+		bool stale = false;
+		auto res = lookup(c, getId, id, h, stale);
+		if (stale) {
+			clear();
+			update(c, getId);
+			res = lookup(c, getId, id, h, stale);
+		}
+		return res;
+	}
+
+	///Removes positions at and above the size (the history was changed from this position)
+	void truncate(std::size_t size) {
+		while (hashes.size() > size) {
+			std::size_t pos = hashes.size()-1;
+			auto rng = map.equal_range(hashes.back());
+			for (auto iter = rng.first; iter != rng.second; ++iter) {
+				if (iter->second == pos) {
+					map.erase(iter);
+					break;
+				}
+			}
+			hashes.pop_back();
+		}
+	}
+
+	void clear() {
+		map.clear();
+		hashes.clear();
+	}
+
+	///Count of indexed items
+	std::size_t size() const {return hashes.size();}
+
+protected:
+	std::unordered_multimap<std::size_t, std::size_t> map;
+	///hashes by position (used to truncate the index)
+	std::vector<std::size_t> hashes;
+
+	template<typename Container, typename GetId, typename Id>
+	std::optional<std::size_t> lookup(const Container &c, GetId &getId, const Id &id, std::size_t h, bool &stale) const {
+		auto rng = map.equal_range(h);
+		for (auto iter = rng.first; iter != rng.second; ++iter) {
+			const auto &itemId = getId(c[iter->second]);
+			if (equal(itemId, id)) return iter->second;
+			//hash collision is fine, but different hash means, that the item was replaced
+			if (hash(json::Value(itemId)) != h) stale = true;
+		}
+		return std::optional<std::size_t>();
+	}
+
+	template<typename Container, typename GetId>
+	void update(const Container &c, GetId &&getId) {
+		for (std::size_t i = hashes.size(), cnt = c.size(); i < cnt; i++) {
+			std::size_t h = hash(json::Value(getId(c[i])));
+			map.emplace(h, i);
+			hashes.push_back(h);
+		}
+	}
+
+	static bool equal(const json::Value &a, const json::Value &b) {
+		return a == b;
+	}
+	static bool equal(const json::Value &a, std::string_view b) {
+		json::String s = a.toString();
+		json::StrViewA v = s.str();
+		return std::string_view(v.data, v.length) == b;
+	}
+};
+
+
+#endif /* SRC_MAIN_TRADE_ID_INDEX_H_ */
@@ -0,0 +1,147 @@
+/*
+ * trade_index.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "trade_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+
+TradeIndex::Entry TradeIndex::Entry::fromRecord(json::Value rec) {
+	return Entry{
+		rec["time"].getUInt(),
+		rec["id"],
+		rec["price"].getNumber(),
+		rec["achg"].getNumber(),
+		rec["volume"].getNumber(),
+		rec["gain"].getNumber(),
+		rec["normch"].getNumber(),
+		rec["pl"].getNumber(),
+		rec["man"].getBool()
+	};
+}
+
+json::Value TradeIndex::Entry::toJSON() const {
+	return json::Object
+			("id", id)
+			("time", time)
+			("price", price)
+			("size", size)
+			("volume", volume)
+			("gain", gain)
+			("normch", normch)
+			("pl", pl)
+			("man", manual);
+}
+
+void TradeIndex::clear() {
+	std::lock_guard<std::mutex> _(lock);
+	entries.clear();
+	last.reset();
+}
+
+void TradeIndex::push(const Entry &e) {
+	std::lock_guard<std::mutex> _(lock);
+	if (entries.empty() || entries.back().time <= e.time) {
+		entries.push_back(e);
+	} else {
+		//keep the index sorted
+		auto iter = std::upper_bound(entries.begin(), entries.end(), e.time,
+				[](std::uint64_t tm, const Entry &x) {return tm < x.time;});
+		entries.insert(iter, e);
+	}
+}
+
+void TradeIndex::setLast(const std::optional<Entry> &e) {
+	std::lock_guard<std::mutex> _(lock);
+	last = e;
+}
+
+std::size_t TradeIndex::size() const {
+	std::lock_guard<std::mutex> _(lock);
+	return entries.size() + (last.has_value()?1:0);
+}
+
+template<typename Fn>
+void TradeIndex::forRange(std::uint64_t from, std::uint64_t to, Fn &&fn) const {
+	auto beg = std::lower_bound(entries.begin(), entries.end(), from,
+			[](const Entry &x, std::uint64_t tm) {return x.time < tm;});
+	auto end = std::lower_bound(beg, entries.end(), to,
+			[](const Entry &x, std::uint64_t tm) {return x.time < tm;});
+	for (auto iter = beg; iter != end; ++iter) {
+		if (!fn(*iter)) return;
+	}
+	if (last.has_value() && last->time >= from && last->time < to) fn(*last);
+}
+
+std::size_t TradeIndex::countRange(std::uint64_t from, std::uint64_t to) const {
+	auto beg = std::lower_bound(entries.begin(), entries.end(), from,
+			[](const Entry &x, std::uint64_t tm) {return x.time < tm;});
+	auto end = std::lower_bound(beg, entries.end(), to,
+			[](const Entry &x, std::uint64_t tm) {return x.time < tm;});
+	std::size_t cnt = std::distance(beg, end);
+	if (last.has_value() && last->time >= from && last->time < to) cnt++;
+	return cnt;
+}
+
+json::Value TradeIndex::query(std::uint64_t from, std::uint64_t to, std::size_t offset, std::size_t limit) const {
+	std::lock_guard<std::mutex> _(lock);
+	std::size_t total = countRange(from, to);
+	json::Array trades;
+	trades.reserve(std::min(limit, total > offset?total-offset:0));
+	std::size_t pos = 0;
+	forRange(from, to, [&](const Entry &e) {
+		if (pos >= offset + limit) return false;
+		if (pos >= offset) trades.push_back(e.toJSON());
+		++pos;
+		return true;
+	});
+	return json::Object
+			("total", total)
+			("offset", offset)
+			("trades", trades);
+}
+
+json::Value TradeIndex::aggregate(std::uint64_t from, std::uint64_t to, std::uint64_t period) const {
+	std::lock_guard<std::mutex> _(lock);
+	json::Array res;
+	std::uint64_t cur_time = 0;
+	std::size_t count = 0, buys = 0, sells = 0;
+	double volume = 0, gain = 0, normch = 0, pl = 0;
+	auto flush = [&] {
+		if (count) {
+			res.push_back(json::Object
+					("time", cur_time)
+					("count", count)
+					("buys", buys)
+					("sells", sells)
+					("volume", volume)
+					("gain", gain)
+					("normch", normch)
+					("pl", pl));
+		}
+		count = buys = sells = 0;
+		volume = gain = normch = 0;
+	};
+	forRange(from, to, [&](const Entry &e) {
+		std::uint64_t t = e.time - e.time % period;
+		if (t != cur_time) {
+			flush();
+			cur_time = t;
+		}
+		count++;
+		if (e.size > 0) buys++;
+		else if (e.size < 0) sells++;
+		volume += std::abs(e.volume);
+		gain += e.gain;
+		normch += e.normch;
+		pl = e.pl;
+		return true;
+	});
+	flush();
+	return res;
+}
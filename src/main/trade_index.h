@@ -0,0 +1,87 @@
+/*
+ * trade_index.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_TRADE_INDEX_H_
+#define SRC_MAIN_TRADE_INDEX_H_
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <imtjson/value.h>
+
+///Time index over the whole trade history of a trader
+/**
+ * The index is fed by the Report as the trades are processed. It keeps
+ * the trades sorted by time, so range queries are resolved by binary search.
+ *
+ * The object is thread safe. It is written by the trading thread and
+ * read by the threads of the HTTP server
+ */
+class TradeIndex {
+public:
+
+	struct Entry {
+		std::uint64_t time;
+		json::Value id;
+		double price;
+		///change of the position (negative for sell)
+		double size;
+		///volume in currency (negative for buy)
+		double volume;
+		double gain;
+		///change of the normalized profit
+		double normch;
+		///profit and loss from the position
+		double pl;
+		bool manual;
+
+		///Creates entry from the report's trade record
+		static Entry fromRecord(json::Value rec);
+		json::Value toJSON() const;
+	};
+
+	///Removes all entries
+	void clear();
+	///Adds processed trade
+	void push(const Entry &e);
+	///Sets the last trade, which can be still changed
+	void setLast(const std::optional<Entry> &e);
+	///Returns count of trades
+	std::size_t size() const;
+
+	///Returns trades in given range
+	/**
+	 * @param from start time (including)
+	 * @param to end time (excluding)
+	 * @param offset count of trades in the range to skip
+	 * @param limit max count of returned trades
+	 * @return object {total, offset, trades:[...]}
+	 */
+	json::Value query(std::uint64_t from, std::uint64_t to, std::size_t offset, std::size_t limit) const;
+	///Returns aggregated statistics in given range
+	/**
+	 * @param from start time (including)
+	 * @param to end time (excluding)
+	 * @param period length of the aggregation period in milliseconds
+	 * @return array of periods with trades [{time, count, buys, sells, volume, gain, normch, pl}]
+	 */
+	json::Value aggregate(std::uint64_t from, std::uint64_t to, std::uint64_t period) const;
+
+protected:
+	mutable std::mutex lock;
+	std::vector<Entry> entries;
+	std::optional<Entry> last;
+
+	///Calls the function for every entry in the range (including the last trade)
+	template<typename Fn> void forRange(std::uint64_t from, std::uint64_t to, Fn &&fn) const;
+	std::size_t countRange(std::uint64_t from, std::uint64_t to) const;
+};
+
+
+
+#endif /* SRC_MAIN_TRADE_INDEX_H_ */
@@ -0,0 +1,114 @@
+/*
+ * walk_forward.cpp
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#include "walk_forward.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "parallel.h"
+#include "spread_calc.h"
+
+WalkForward::WalkForward(ondra_shared::StringView<ChartItem> chart,
+		const IStockApi::MarketInfo &minfo,
+		std::vector<Candidate> &&candidates,
+		double balance)
+	:chart(chart),minfo(minfo),candidates(std::move(candidates)),balance(balance) {
+	if (this->candidates.empty()) throw std::runtime_error("Walk-forward: no candidates");
+}
+
+std::size_t WalkForward::find(std::size_t begin, std::size_t end, std::uintptr_t tm) const {
+	const ChartItem *beg = chart.data;
+	return static_cast<std::size_t>(std::lower_bound(beg+begin, beg+end, tm, [](const ChartItem &itm, std::uintptr_t t) {
+		return itm.time < t;
+	}) - beg);
+}
+
+std::vector<WalkForward::Window> WalkForward::split(std::uint64_t train_ms, std::uint64_t test_ms) const {
+	std::vector<Window> res;
+	if (chart.empty() || train_ms == 0 || test_ms == 0) return res;
+	std::uintptr_t t = chart[0].time;
+	while (true) {
+		Window w;
+		w.train_begin = find(0, chart.length, t);
+		w.train_end = find(0, chart.length, t+train_ms);
+		w.test_end = find(0, chart.length, t+train_ms+test_ms);
+		if (w.train_end >= chart.length) break;
+		if (w.train_end > w.train_begin) res.push_back(w);
+		t += test_ms;
+	}
+	return res;
+}
+
+double WalkForward::calcSpread(const Window &w) const {
+	const MTrader_Config &cfg = candidates[0].cfg.mtrader_cfg;
+	std::uintptr_t end_time = chart[w.train_end-1].time;
+	std::uintptr_t beg_time = end_time > cfg.spread_calc_mins*60000ULL?end_time - cfg.spread_calc_mins*60000ULL:0;
+	std::size_t beg = find(w.train_begin, w.train_end, beg_time);
+	return glob_calcSpread(chart.substr(beg, w.train_end - beg), cfg, minfo, balance, 0);
+}
+
+BacktestControl::Result WalkForward::backtest(const Candidate &c, std::size_t begin, std::size_t end, double spread) const {
+	BacktestControl bt(minfo, std::make_unique<BacktestStatSvc>(c.cfg.calc_spread_minutes),
+			c.cfg, chart.substr(begin, end-begin), spread, balance);
+	while (bt.step()) {}
+	return bt.getResult();
+}
+
+std::vector<WalkForward::WindowResult> WalkForward::run(const std::vector<Window> &windows, unsigned int threads, ProgressFn progress) const {
+	std::size_t wcnt = windows.size();
+	std::size_t ccnt = candidates.size();
+	std::vector<WindowResult> res(wcnt);
+
+	//spreads of all windows
+	parallel_for(wcnt, threads, [&](std::size_t w, unsigned int) {
+		res[w].window = windows[w];
+		res[w].spread = calcSpread(windows[w]);
+	});
+
+	//all candidates on all training parts
+	std::vector<BacktestControl::Result> train(wcnt*ccnt);
+	parallel_for(wcnt*ccnt, threads, [&](std::size_t idx, unsigned int) {
+		const Window &w = windows[idx / ccnt];
+		train[idx] = backtest(candidates[idx % ccnt], w.train_begin, w.train_end, res[idx / ccnt].spread);
+	});
+
+	//the best candidates on the test parts
+	std::mutex lock;
+	parallel_for(wcnt, threads, [&](std::size_t w, unsigned int) {
+		auto beg = train.begin()+w*ccnt;
+		auto best = std::max_element(beg, beg+ccnt, [](const BacktestControl::Result &a, const BacktestControl::Result &b) {
+			return a.profit < b.profit;
+		});
+		WindowResult &r = res[w];
+		r.best = std::distance(beg, best);
+		r.train = *best;
+		r.test = backtest(candidates[r.best], r.window.train_end, r.window.test_end, r.spread);
+		if (progress) {
+			std::lock_guard<std::mutex> _(lock);
+			progress(r);
+		}
+	});
+	return res;
+}
+
+WalkForward::Summary WalkForward::summarize(const std::vector<WindowResult> &results) const {
+	Summary s{0,0,0,0,0};
+	double train_time = 0, test_time = 0;
+	for (auto &&r: results) {
+		s.train_profit += r.train.profit;
+		s.test_profit += r.test.profit;
+		s.test_trades += r.test.trades;
+		s.test_drawdown = std::max(s.test_drawdown, r.test.drawdown);
+		train_time += chart[r.window.train_end-1].time - chart[r.window.train_begin].time;
+		if (r.window.test_end > r.window.train_end)
+			test_time += chart[r.window.test_end-1].time - chart[r.window.train_end].time;
+	}
+	if (train_time > 0 && test_time > 0 && s.train_profit != 0) {
+		s.efficiency = (s.test_profit/test_time)/(s.train_profit/train_time);
+	}
+	return s;
+}
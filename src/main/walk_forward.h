@@ -0,0 +1,122 @@
+/*
+ * walk_forward.h
+ *
+ *  Created on: 18. 10. 2026
+ */
+
+#ifndef SRC_MAIN_WALK_FORWARD_H_
+#define SRC_MAIN_WALK_FORWARD_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "backtest.h"
+
+///Walk-forward optimization
+/**
+ * The chart is split into rolling windows. Every window has a training part and a test
+ * part which follows it. The spread is calculated on the training part (glob_calcSpread) and
+ * all candidates (combinations of options) are backtested on it. The best candidate is
+ * then backtested on the test part. Test parts don't overlap, so the results of the test
+ * parts form together an out-of-sample result.
+ *
+ * All backtests of all windows are independent and they are executed in parallel
+ */
+class WalkForward {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+
+	///Combination of options
+	struct Candidate {
+		///description (option=value ...)
+		std::string desc;
+		BacktestControl::Config cfg;
+	};
+
+	///Window (indexes to the chart)
+	struct Window {
+		std::size_t train_begin;
+		///end of the training part, which is also beginning of the test part
+		std::size_t train_end;
+		std::size_t test_end;
+	};
+
+	///Result of the window
+	struct WindowResult {
+		Window window;
+		///spread calculated on the training part (logarithmic)
+		double spread;
+		///index of the best candidate
+		std::size_t best;
+		///result of the best candidate on the training part
+		BacktestControl::Result train;
+		///result of the best candidate on the test part
+		BacktestControl::Result test;
+	};
+
+	///Aggregated out-of-sample result
+	struct Summary {
+		double train_profit;
+		double test_profit;
+		unsigned int test_trades;
+		///largest drawdown of all test parts
+		double test_drawdown;
+		///profit per time of the test parts relative to the profit per time of the training parts
+		double efficiency;
+	};
+
+	///Called when the window is finished - called from the pool's threads, but serialized
+	using ProgressFn = std::function<void(const WindowResult &)>;
+
+	///Initializes the optimization
+	/**
+	 * @param chart chart (must stay valid during lifetime of the object)
+	 * @param minfo market info
+	 * @param candidates list of candidates (at least one)
+	 * @param balance initial balance of the backtests
+	 */
+	WalkForward(ondra_shared::StringView<ChartItem> chart,
+			const IStockApi::MarketInfo &minfo,
+			std::vector<Candidate> &&candidates,
+			double balance);
+
+	///Splits the chart into windows
+	/**
+	 * @param train_ms length of the training part in milliseconds
+	 * @param test_ms length of the test part in milliseconds. Windows are moved by this length
+	 * @return list of windows. The last test part can be shorter
+	 */
+	std::vector<Window> split(std::uint64_t train_ms, std::uint64_t test_ms) const;
+
+	///Runs the optimization
+	/**
+	 * @param windows windows to process
+	 * @param threads count of threads (0 = all CPUs)
+	 * @param progress function called when a window is finished
+	 * @return results in order of windows
+	 */
+	std::vector<WindowResult> run(const std::vector<Window> &windows, unsigned int threads, ProgressFn progress) const;
+
+	///Aggregates results of windows
+	Summary summarize(const std::vector<WindowResult> &results) const;
+
+	const Candidate &getCandidate(std::size_t idx) const {return candidates[idx];}
+	std::uintptr_t getTime(std::size_t idx) const {return chart[idx].time;}
+
+protected:
+	///the chart is not copied, backtests convert it to columns by chunks
+	ondra_shared::StringView<ChartItem> chart;
+	IStockApi::MarketInfo minfo;
+	std::vector<Candidate> candidates;
+	double balance;
+
+	///Finds the first item at or after the time in the range of indexes
+	std::size_t find(std::size_t begin, std::size_t end, std::uintptr_t tm) const;
+	BacktestControl::Result backtest(const Candidate &c, std::size_t begin, std::size_t end, double spread) const;
+	double calcSpread(const Window &w) const;
+};
+
+
+#endif /* SRC_MAIN_WALK_FORWARD_H_ */
@@ -12,6 +12,7 @@
 #include "config.h"
 #include "proxy.h"
 #include "../main/istockapi.h"
+#include "../main/trade_id_index.h"
 #include <cmath>
 #include <ctime>
 
@@ -54,6 +55,8 @@ public:
 
 
 	TradeMap tradeMap;
+	///index of trade ids for every pair (lookup of lastId)
+	ondra_shared::linear_map<std::string, TradeIdIndex> tradeIndex;
 	bool needSyncTrades = true;
 	std::size_t lastFromTime = -1;
 
@@ -102,6 +105,7 @@ public:
 
 		if (fromTime < lastFromTime) {
 			tradeMap.clear();
+			tradeIndex.clear();
 			needSyncTrades = true;
 			lastFromTime = fromTime;
 		}
@@ -111,15 +115,13 @@ public:
 			needSyncTrades = false;
 		}
 
-		auto trs = tradeMap[pair];
+		const auto &trs = tradeMap[pair];
 
 		auto iter = trs.begin();
 		auto end = trs.end();
 		if (lastId.defined()) {
-			iter = std::find_if(iter, end, [&](const Trade &x){
-				return x.id == lastId;
-			});
-			if (iter != end) ++iter;
+			auto pos = tradeIndex[pair].find(trs, [](const Trade &x) {return x.id;}, lastId);
+			iter = pos.has_value()?iter + *pos + 1:end;
 		}
 
 
@@ -545,153 +545,198 @@ function app_start(){
 	
 	}
 	
+	var cur_stats = null;
+
+	function apply_chart(stats, symb, d) {
+		var recs = (stats.charts[symb] || []).filter(function(r) {
+			return d.trim !== null && d.from !== null && r.time >= d.trim && r.time < d.from;
+		});
+		stats.charts[symb] = recs.concat(d.records);
+	}
+
+	function apply_delta(stats, delta) {
+		["info","prices","misc"].forEach(function(sect) {
+			var src = delta[sect];
+			var trg = stats[sect] || (stats[sect] = {});
+			for (var k in src) trg[k] = src[k];
+		});
+		var charts = delta.charts || {};
+		for (var k in charts) apply_chart(stats, k, charts[k]);
+		var osymb = {};
+		(delta.orders_symb || []).forEach(function(s) {osymb[s] = true;});
+		stats.orders = (stats.orders || []).filter(function(o) {
+			return !osymb[o.symb];
+		}).concat(delta.orders || []);
+		stats.log = delta.log;
+		stats.time = delta.time;
+		stats.interval = delta.interval;
+		stats.rev = delta.rev;
+		return stats;
+	}
+
+	function fetch_stats() {
+		if (cur_stats === null || cur_stats.rev === undefined) {
+			return fetch_json("report.json?r="+Date.now());
+		}
+		return fetch_json("report_delta.json?r="+Date.now()).then(function(delta) {
+			if (delta.base > cur_stats.rev) return fetch_json("report.json?r="+Date.now());
+			if (delta.rev <= cur_stats.rev) return cur_stats;
+			return apply_delta(cur_stats, delta);
+		}, function() {
+			return fetch_json("report.json?r="+Date.now());
+		});
+	}
+
 	function update() {
 		
 		indicator.classList.remove("online");
 		indicator.classList.add("fetching");
-		return fetch_json("report.json?r="+Date.now()).then((stats)=>{
+		return fetch_stats().then(show,function(e) {
+			indicator.classList.remove("fetching");
+			console.error(e);
+		});
+	}
 
-			
-			var orders = {};
-			var ranges = {};
-			
-			infoMap = stats.info;			
-			
-			document.getElementById("logfile").innerText = " > "+ stats["log"].join("\r\n > ");
+	function show(stats) {
 
-			
-			var charts = stats["charts"];
-			for (var n in charts) {
-				var ch = charts[n];				
-				orders[n] = [];
-				ranges[n] = {};
-				adjChartData(charts[n], n);
-				updateOptions(n, infoMap[n].title);
+		cur_stats = stats;
+		
+		var orders = {};
+		var ranges = {};
+		
+		infoMap = stats.info;			
+		
+		document.getElementById("logfile").innerText = " > "+ stats["log"].join("\r\n > ");
+
+		
+		var charts = stats["charts"];
+		for (var n in charts) {
+			var ch = charts[n];				
+			orders[n] = [];
+			ranges[n] = {};
+			adjChartData(charts[n], n);
+			updateOptions(n, infoMap[n].title);
+		}
+		
+		(stats.orders || []).forEach(function(o) {
+			var s = orders[o.symb];
+			var sz = o.size;
+			var ch =  charts[o.symb];
+			var inv = infoMap[o.symb].inverted;
+			var last;
+			if (!ch || !ch.length) {
+				last = {pl:0,price:o.price,pos:0};
+			} else {
+				 last = ch[ch.length-1];
 			}
-			
-			(stats.orders || []).forEach(function(o) {
-				var s = orders[o.symb];
-				var sz = o.size;
-				var ch =  charts[o.symb];
-				var inv = infoMap[o.symb].inverted;
-				var last;
-				if (!ch || !ch.length) {
-					last = {pl:0,price:o.price,pos:0};
-				} else {
-					 last = ch[ch.length-1];
-				}
-				var dir = o.dir < 0?"sell":"buy";
-				var gain = ((inv?1.0/o.price:o.price) - (inv?1.0/last.price:last.price))* (inv?-1:1)*last.pos;
-				var newpl = last.pl + gain;
-				var newpos = last.pos + sz;
-				s.push({
-					price: o.price,
-					achg: sz,
-					pl: newpl,
-					pos: newpos,
-					label: "",
-					gain:gain,
-					class: dir,
-				})
-				ranges[o.symb][dir] = [o.price,o.size];
-				ranges[o.symb].pos = [last.pos,infoMap[o.symb].asset];
-			}) 
-			
-			for (var sm in stats.prices) {
-				var s = orders[sm];
-				var ch =  charts[sm];
-				var inv = infoMap[sm].inverted;
-				var last;
-				if (!ch || !ch.length) {
-					last = {pl:0,price:stats.prices[sm],pos:0,app:0,norm:0,nacum:0};
-				} else {
-					 last = ch[ch.length-1];
-				}
-				if (!s) orders[o.symb] = s = [];				
-				var gain = ((inv?1.0/stats.prices[sm]:stats.prices[sm])- (inv?1.0/last.price:last.price))* (inv?-1:1)*last.pos;
-				s.push({
-					price: stats.prices[sm],
-					pl: last.pl + gain,
-					label: "",
-					class: "last",
-				})
-				ranges[sm]["last"] = [stats.prices[sm],""];
-			
+			var dir = o.dir < 0?"sell":"buy";
+			var gain = ((inv?1.0/o.price:o.price) - (inv?1.0/last.price:last.price))* (inv?-1:1)*last.pos;
+			var newpl = last.pl + gain;
+			var newpos = last.pos + sz;
+			s.push({
+				price: o.price,
+				achg: sz,
+				pl: newpl,
+				pos: newpos,
+				label: "",
+				gain:gain,
+				class: dir,
+			})
+			ranges[o.symb][dir] = [o.price,o.size];
+			ranges[o.symb].pos = [last.pos,infoMap[o.symb].asset];
+		}) 
+		
+		for (var sm in stats.prices) {
+			var s = orders[sm];
+			var ch =  charts[sm];
+			var inv = infoMap[sm].inverted;
+			var last;
+			if (!ch || !ch.length) {
+				last = {pl:0,price:stats.prices[sm],pos:0,app:0,norm:0,nacum:0};
+			} else {
+				 last = ch[ch.length-1];
 			}
+			if (!s) orders[o.symb] = s = [];				
+			var gain = ((inv?1.0/stats.prices[sm]:stats.prices[sm])- (inv?1.0/last.price:last.price))* (inv?-1:1)*last.pos;
+			s.push({
+				price: stats.prices[sm],
+				pl: last.pl + gain,
+				label: "",
+				class: "last",
+			})
+			ranges[sm]["last"] = [stats.prices[sm],""];
+		
+		}
 
-			var sums = calculate_sums(charts,infoMap);
-			
-			localStorage["mmbot_time"] = Date.now();
-			
-			chart_interval = stats.interval;
-			redraw = function() {
+		var sums = calculate_sums(charts,infoMap);
+		
+		localStorage["mmbot_time"] = Date.now();
+		
+		chart_interval = stats.interval;
+		redraw = function() {
 
-				var fld = location.hash;
-				if (fld) fld = decodeURIComponent(fld.substr(1));
-				else fld = "+summary";
-				
-				selector.value = fld;
+			var fld = location.hash;
+			if (fld) fld = decodeURIComponent(fld.substr(1));
+			else fld = "+summary";
+			
+			selector.value = fld;
 
-				if (fld == "+summary") {
-					setMode(4);
-					for (var k in charts) {
-						appendSummary("_"+k,infoMap[k], charts[k], ranges[k], stats.misc[k]);
-					}
-					for (var k in sums) {
-						appendSummary("_"+k,{"title":k,"asset":"","currency":k}, sums[k]);
-					}
-					updateLastEventsAll(charts);
-				} else if (fld.startsWith("!")) {
-					setMode(1);
-					var pair = fld.substr(1);
-					appendSummary("_"+k,infoMap[pair], charts[pair], ranges[pair], stats.misc[pair],true);
-					for (var k in cats) {
-						appendChart("!"+k, {title:cats[k]}, charts[pair], k, orders[pair], stats.misc[k]);
-					}
-					updateLastEvents(charts[pair],pair);
-					
-				} else if (fld.startsWith("+")) {
-					setMode(2);
-					fld = fld.substr(1);
-					for (var k in sums) {
-						appendChart(k,{"title":k}, sums[k], fld);
-					}
-					updateLastEventsAll(charts);			
-				} else {
-					setMode(3);
-					for (var k in charts) {
-						appendChart(k,infoMap[k], charts[k], fld,  orders[k],ranges[k], stats.misc[k]);
-					}
-					updateLastEventsAll(charts);
+			if (fld == "+summary") {
+				setMode(4);
+				for (var k in charts) {
+					appendSummary("_"+k,infoMap[k], charts[k], ranges[k], stats.misc[k]);
+				}
+				for (var k in sums) {
+					appendSummary("_"+k,{"title":k,"asset":"","currency":k}, sums[k]);
 				}
-				if (lastField) {
-					selector.value = lastField;
-					lastField = null;
-					redraw();
+				updateLastEventsAll(charts);
+			} else if (fld.startsWith("!")) {
+				setMode(1);
+				var pair = fld.substr(1);
+				appendSummary("_"+k,infoMap[pair], charts[pair], ranges[pair], stats.misc[pair],true);
+				for (var k in cats) {
+					appendChart("!"+k, {title:cats[k]}, charts[pair], k, orders[pair], stats.misc[k]);
 				}
+				updateLastEvents(charts[pair],pair);
 				
+			} else if (fld.startsWith("+")) {
+				setMode(2);
+				fld = fld.substr(1);
+				for (var k in sums) {
+					appendChart(k,{"title":k}, sums[k], fld);
+				}
+				updateLastEventsAll(charts);			
+			} else {
+				setMode(3);
+				for (var k in charts) {
+					appendChart(k,infoMap[k], charts[k], fld,  orders[k],ranges[k], stats.misc[k]);
+				}
+				updateLastEventsAll(charts);
+			}
+			if (lastField) {
+				selector.value = lastField;
+				lastField = null;
+				redraw();
 			}
 			
-			
-			redraw();
+		}
+		
+		
+		redraw();
 
-			indicator.classList.remove("fetching");
-			indicator.classList.add("online");
-			var now = Date.now();
-			var df;
-			if (timediff === null) {
-				df = timediff = now -stats.time;
-			} else {
-				var reqtime = now - timediff;
-				df = reqtime - stats.time;
-				if (df < 0) timediff = now -stats.time;
-			}
-			outage.classList.toggle("detected",df > 100000); 
+		indicator.classList.remove("fetching");
+		indicator.classList.add("online");
+		var now = Date.now();
+		var df;
+		if (timediff === null) {
+			df = timediff = now -stats.time;
+		} else {
+			var reqtime = now - timediff;
+			df = reqtime - stats.time;
+			if (df < 0) timediff = now -stats.time;
+		}
+		outage.classList.toggle("detected",df > 100000); 
 
-		},function(e) {
-			indicator.classList.remove("fetching");
-			console.error(e);
-		});
 	}
 	
 	var base_interval=1200000;
@@ -829,10 +874,62 @@ function app_start(){
 	
 	var logo = document.getElementById("logo");
 	
+	var stream_events = {
+		"price": function(ev) {cur_stats.prices[ev.symb] = ev.price;},
+		"info": function(ev) {cur_stats.info[ev.symb] = ev.info;},
+		"misc": function(ev) {cur_stats.misc[ev.symb] = ev.misc;},
+		"trades": function(ev) {apply_chart(cur_stats, ev.symb, ev.chart);},
+		"orders": function(ev) {
+			cur_stats.orders = cur_stats.orders.filter(function(o) {
+				return o.symb != ev.symb;
+			}).concat(ev.orders);
+		},
+		"log": function(ev) {
+			cur_stats.log.push(ev.line);
+			if (cur_stats.log.length > 30) cur_stats.log.shift();
+		}
+	};
+
+	function start_polling() {
+		setInterval(update,60000);
+	}
+
+	function start_stream() {
+		if (!window.EventSource) return start_polling();
+		var opened = false;
+		var show_timer = null;
+		var src = new EventSource("api/stream");
+		src.onopen = function() {
+			opened = true;
+		};
+		src.onerror = function() {
+			if (!opened) {
+				//streaming is not available, poll the report
+				src.close();
+				start_polling();
+			}
+		};
+		Object.keys(stream_events).forEach(function(k) {
+			src.addEventListener(k, function(e) {
+				if (cur_stats === null) return;
+				stream_events[k](JSON.parse(e.data));
+				//changes come in bursts, show them at once
+				if (show_timer === null) show_timer = setTimeout(function() {
+					show_timer = null;
+					show(cur_stats);
+				}, 250);
+			});
+		});
+		src.addEventListener("rev", function(e) {
+			//synchronize with the generated report
+			if (cur_stats !== null && cur_stats.rev < JSON.parse(e.data).rev) update();
+		});
+	}
+
 	function removeLogo() {
 		update().then(function() {
 			logo.parentNode.removeChild(logo);
-			setInterval(update,60000);
+			start_stream();
 		});
 	}
 	